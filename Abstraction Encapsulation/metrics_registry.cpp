@@ -0,0 +1,478 @@
+/*
+
+---------- METRICS REGISTRY ----------
+
+The Counter class in static_members_and_functions.cpp is the simplest possible metric: one static variable shared by
+every object. A metrics registry takes the same idea further. It is a class with only static members that owns every
+named metric in the process, so any part of the program can look up "bank.deposits" and record into it.
+
+Three kinds of metric are supported:
+
+1. Counter: A value that only goes up (requests served, bytes written). Built like the sharded Counter in
+   sharded_counter.cpp: cache-line-padded slots, one per thread.
+2. Gauge: A value that goes up and down (objects alive, queue length). A single atomic.
+3. Histogram: A distribution of values, usually latencies in nanoseconds. HDR-style log-linear buckets: every power
+   of two is split into 32 equal sub-buckets, so any recorded value is off by at most ~3%, whether it is 50ns or 5s.
+
+---------- HOW IT WORKS ----------
+
+Lookup Once, Record Often: counter()/gauge()/histogram() take a lock and return a reference that stays valid for the
+                           life of the program. Hot paths look the metric up once and then only record.
+Lock-Free Recording: Each thread owns a shard, so recording is a couple of relaxed loads and stores. No locks, no
+                     locked instructions, no allocation.
+Snapshot: snapshot() copies every metric into plain values. It never blocks recorders.
+Export: A snapshot can be written as text (one line per value, easy to grep) or as a compact binary blob
+        (varints, only non-empty histogram buckets) and read back with decodeBinary().
+
+---------- USES ----------
+
+Hot-Path Instrumentation: Count deposits, track live matrices, time roster lookups without adding locks.
+Monitoring: Periodically export a snapshot to a monitoring system.
+Benchmarking: Collect latency percentiles instead of just averages.
+
+---------- RULES AND GUIDELINES ----------
+
+Keep The Reference: Never call counter("name") inside a hot loop; look it up once and keep the reference.
+Units: Histograms take unsigned integers; record latencies in nanoseconds.
+Range: Histogram values above 2^40 (about 18 minutes in ns) are clamped into the last bucket.
+Compile: g++ -std=c++17 -O2 -pthread metrics_registry.cpp
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Every thread claims one of EXCLUSIVE_SHARDS shards for as long as it lives. Only that thread writes its shard,
+// so recording is a plain load + store instead of a locked read-modify-write. Threads beyond EXCLUSIVE_SHARDS
+// share the last (overflow) shard and fall back to fetch_add.
+class ThreadShard {
+public:
+    static constexpr size_t EXCLUSIVE_SHARDS = 16;
+    static constexpr size_t SHARD_COUNT = EXCLUSIVE_SHARDS + 1;
+
+    static size_t index() {
+        thread_local Claim claim;
+        return claim.index;
+    }
+
+    static void add(atomic<uint64_t>& slot, uint64_t by, size_t shard) {
+        if (shard < EXCLUSIVE_SHARDS) {
+            slot.store(slot.load(memory_order_relaxed) + by, memory_order_relaxed);
+        } else {
+            slot.fetch_add(by, memory_order_relaxed);
+        }
+    }
+
+private:
+    static atomic<uint32_t> claimed;
+
+    struct Claim {
+        size_t index = EXCLUSIVE_SHARDS;
+
+        Claim() {
+            uint32_t mask = claimed.load(memory_order_relaxed);
+            while (mask != (uint32_t(1) << EXCLUSIVE_SHARDS) - 1) {
+                unsigned free = static_cast<unsigned>(__builtin_ctz(~mask));
+                if (claimed.compare_exchange_weak(mask, mask | (uint32_t(1) << free), memory_order_acquire)) {
+                    index = free;
+                    break;
+                }
+            }
+        }
+
+        // The shard keeps its values; the next thread to claim it carries on adding
+        ~Claim() {
+            if (index < EXCLUSIVE_SHARDS) {
+                claimed.fetch_and(~(uint32_t(1) << index), memory_order_release);
+            }
+        }
+    };
+};
+
+atomic<uint32_t> ThreadShard::claimed{0};
+
+class MetricCounter {
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        atomic<uint64_t> value{0};
+    };
+
+    Shard shards[ThreadShard::SHARD_COUNT];
+
+public:
+    void increment(uint64_t by = 1) {
+        size_t shard = ThreadShard::index();
+        ThreadShard::add(shards[shard].value, by, shard);
+    }
+
+    uint64_t get() const {
+        uint64_t total = 0;
+        for (const Shard& s : shards) {
+            total += s.value.load(memory_order_relaxed);
+        }
+        return total;
+    }
+};
+
+class Gauge {
+private:
+    alignas(CACHE_LINE_SIZE) atomic<int64_t> value{0};
+
+public:
+    void set(int64_t v) { value.store(v, memory_order_relaxed); }
+    void add(int64_t by) { value.fetch_add(by, memory_order_relaxed); }
+    int64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+// Plain copy of a histogram, returned by Histogram::snapshot()
+struct HistogramSnapshot {
+    vector<uint64_t> buckets;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    uint64_t count() const {
+        uint64_t c = 0;
+        for (uint64_t b : buckets) {
+            c += b;
+        }
+        return c;
+    }
+
+    // Value at quantile q (0..1), reported as the midpoint of its bucket
+    uint64_t percentile(double q) const;
+
+    bool operator==(const HistogramSnapshot& other) const {
+        return buckets == other.buckets && sum == other.sum && max == other.max;
+    }
+};
+
+class Histogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;
+    static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_BITS) - 1;
+    static constexpr size_t BUCKET_COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    // Values below SUB_COUNT get their own bucket; above that each power of two has SUB_COUNT buckets
+    static size_t bucketIndex(uint64_t v) {
+        if (v < SUB_COUNT) {
+            return static_cast<size_t>(v);
+        }
+        v = min(v, MAX_VALUE);
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(v));
+        unsigned shift = exponent - SUB_BITS;
+        return static_cast<size_t>(shift * SUB_COUNT + (v >> shift));
+    }
+
+    static uint64_t bucketLowerBound(size_t index) {
+        if (index < SUB_COUNT) {
+            return index;
+        }
+        uint64_t shift = index / SUB_COUNT - 1;
+        uint64_t mantissa = index - shift * SUB_COUNT;
+        return mantissa << shift;
+    }
+
+    static uint64_t bucketUpperBound(size_t index) {
+        return index + 1 < BUCKET_COUNT ? bucketLowerBound(index + 1) - 1 : MAX_VALUE;
+    }
+
+    void record(uint64_t v) {
+        size_t shard = ThreadShard::index();
+        Shard& s = shards[shard];
+        ThreadShard::add(s.buckets[bucketIndex(v)], 1, shard);
+        ThreadShard::add(s.sum, v, shard);
+        uint64_t seen = s.max.load(memory_order_relaxed);
+        while (v > seen && !s.max.compare_exchange_weak(seen, v, memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot snap;
+        snap.buckets.assign(BUCKET_COUNT, 0);
+        for (const Shard& s : shards) {
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                snap.buckets[i] += s.buckets[i].load(memory_order_relaxed);
+            }
+            snap.sum += s.sum.load(memory_order_relaxed);
+            snap.max = max(snap.max, s.max.load(memory_order_relaxed));
+        }
+        return snap;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+        atomic<uint64_t> sum{0};
+        atomic<uint64_t> max{0};
+    };
+
+    Shard shards[ThreadShard::SHARD_COUNT];
+};
+
+uint64_t HistogramSnapshot::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t lo = Histogram::bucketLowerBound(i);
+            uint64_t hi = Histogram::bucketUpperBound(i);
+            return min(lo + (hi - lo) / 2, max);
+        }
+    }
+    return max;
+}
+
+// Plain copy of every metric in the registry
+struct MetricsSnapshot {
+    map<string, uint64_t> counters;
+    map<string, int64_t> gauges;
+    map<string, HistogramSnapshot> histograms;
+
+    bool operator==(const MetricsSnapshot& other) const {
+        return counters == other.counters && gauges == other.gauges && histograms == other.histograms;
+    }
+};
+
+class MetricsRegistry {
+private:
+    static mutex mtx;
+    static map<string, unique_ptr<MetricCounter>> counters;
+    static map<string, unique_ptr<Gauge>> gauges;
+    static map<string, unique_ptr<Histogram>> histograms;
+
+    template <typename M>
+    static M& findOrCreate(map<string, unique_ptr<M>>& metrics, const string& name) {
+        lock_guard<mutex> lock(mtx);
+        unique_ptr<M>& slot = metrics[name];
+        if (!slot) {
+            slot = make_unique<M>();
+        }
+        return *slot;
+    }
+
+public:
+    // Lookups take the lock; keep the returned reference for recording
+    static MetricCounter& counter(const string& name) { return findOrCreate(counters, name); }
+    static Gauge& gauge(const string& name) { return findOrCreate(gauges, name); }
+    static Histogram& histogram(const string& name) { return findOrCreate(histograms, name); }
+
+    static MetricsSnapshot snapshot() {
+        lock_guard<mutex> lock(mtx);
+        MetricsSnapshot snap;
+        for (const auto& [name, c] : counters) {
+            snap.counters[name] = c->get();
+        }
+        for (const auto& [name, g] : gauges) {
+            snap.gauges[name] = g->get();
+        }
+        for (const auto& [name, h] : histograms) {
+            snap.histograms[name] = h->snapshot();
+        }
+        return snap;
+    }
+};
+
+// Definition of the static member variables
+mutex MetricsRegistry::mtx;
+map<string, unique_ptr<MetricCounter>> MetricsRegistry::counters;
+map<string, unique_ptr<Gauge>> MetricsRegistry::gauges;
+map<string, unique_ptr<Histogram>> MetricsRegistry::histograms;
+
+// ---------- EXPORT ----------
+
+string exportText(const MetricsSnapshot& snap) {
+    string out;
+    char line[256];
+    for (const auto& [name, value] : snap.counters) {
+        snprintf(line, sizeof(line), "counter %s %llu\n", name.c_str(), (unsigned long long)value);
+        out += line;
+    }
+    for (const auto& [name, value] : snap.gauges) {
+        snprintf(line, sizeof(line), "gauge %s %lld\n", name.c_str(), (long long)value);
+        out += line;
+    }
+    for (const auto& [name, h] : snap.histograms) {
+        snprintf(line, sizeof(line), "histogram %s count=%llu sum=%llu p50=%llu p90=%llu p99=%llu p999=%llu max=%llu\n",
+                 name.c_str(), (unsigned long long)h.count(), (unsigned long long)h.sum,
+                 (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.90),
+                 (unsigned long long)h.percentile(0.99), (unsigned long long)h.percentile(0.999),
+                 (unsigned long long)h.max);
+        out += line;
+    }
+    return out;
+}
+
+// Binary layout: "MTR1", then per metric: kind byte, varint name length, name, payload.
+//   counter:   varint value
+//   gauge:     zigzag varint value
+//   histogram: varint sum, varint max, varint non-empty buckets, then (varint index delta, varint count) pairs
+enum MetricKind : uint8_t { KIND_COUNTER = 1, KIND_GAUGE = 2, KIND_HISTOGRAM = 3 };
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static bool getVarint(const string& in, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void putName(string& out, MetricKind kind, const string& name) {
+    out.push_back(static_cast<char>(kind));
+    putVarint(out, name.size());
+    out += name;
+}
+
+string exportBinary(const MetricsSnapshot& snap) {
+    string out = "MTR1";
+    for (const auto& [name, value] : snap.counters) {
+        putName(out, KIND_COUNTER, name);
+        putVarint(out, value);
+    }
+    for (const auto& [name, value] : snap.gauges) {
+        putName(out, KIND_GAUGE, name);
+        putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+    for (const auto& [name, h] : snap.histograms) {
+        putName(out, KIND_HISTOGRAM, name);
+        putVarint(out, h.sum);
+        putVarint(out, h.max);
+        size_t nonEmpty = count_if(h.buckets.begin(), h.buckets.end(), [](uint64_t b) { return b != 0; });
+        putVarint(out, nonEmpty);
+        size_t previous = 0;
+        for (size_t i = 0; i < h.buckets.size(); ++i) {
+            if (h.buckets[i] != 0) {
+                putVarint(out, i - previous);
+                putVarint(out, h.buckets[i]);
+                previous = i;
+            }
+        }
+    }
+    return out;
+}
+
+// Returns false if the blob is truncated or malformed
+bool decodeBinary(const string& in, MetricsSnapshot& snap) {
+    if (in.compare(0, 4, "MTR1") != 0) {
+        return false;
+    }
+    size_t pos = 4;
+    while (pos < in.size()) {
+        uint8_t kind = static_cast<uint8_t>(in[pos++]);
+        uint64_t len = 0, value = 0;
+        if (!getVarint(in, pos, len) || len > in.size() - pos) {
+            return false;
+        }
+        string name = in.substr(pos, len);
+        pos += len;
+
+        if (kind == KIND_COUNTER) {
+            if (!getVarint(in, pos, value)) return false;
+            snap.counters[name] = value;
+        } else if (kind == KIND_GAUGE) {
+            if (!getVarint(in, pos, value)) return false;
+            snap.gauges[name] = static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+        } else if (kind == KIND_HISTOGRAM) {
+            HistogramSnapshot h;
+            h.buckets.assign(Histogram::BUCKET_COUNT, 0);
+            uint64_t nonEmpty = 0;
+            if (!getVarint(in, pos, h.sum) || !getVarint(in, pos, h.max) || !getVarint(in, pos, nonEmpty)) {
+                return false;
+            }
+            uint64_t index = 0;
+            for (uint64_t i = 0; i < nonEmpty; ++i) {
+                uint64_t delta = 0, count = 0;
+                if (!getVarint(in, pos, delta) || !getVarint(in, pos, count)) return false;
+                index += delta;
+                if (index >= Histogram::BUCKET_COUNT) return false;
+                h.buckets[index] = count;
+            }
+            snap.histograms[name] = move(h);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double nsPerOp(long long iterations, F&& f) {
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < iterations; ++i) {
+        f(i);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    // Look the metrics up once, like a hot path would
+    MetricCounter& deposits = MetricsRegistry::counter("bank.deposits");
+    Gauge& liveMatrices = MetricsRegistry::gauge("matrix.live");
+    Histogram& lookupNs = MetricsRegistry::histogram("roster.lookup_ns");
+
+    // Several threads recording at once
+    vector<thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < 100000; ++i) {
+                deposits.increment();
+                liveMatrices.add(i % 2 ? -1 : 1);
+                lookupNs.record(static_cast<uint64_t>(100 + (i * 7 + t) % 900));
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    MetricsSnapshot snap = MetricsRegistry::snapshot();
+    cout << exportText(snap);
+
+    string blob = exportBinary(snap);
+    MetricsSnapshot decoded;
+    bool ok = decodeBinary(blob, decoded) && decoded == snap;
+    cout << "binary export: " << blob.size() << " bytes, round trip " << (ok ? "ok" : "FAILED") << endl;
+
+    // Recording cost on one thread
+    const long long N = 20000000;
+    Histogram& benchHist = MetricsRegistry::histogram("bench.latency_ns");
+    printf("\ncounter.increment  %6.2f ns/op\n", nsPerOp(N, [&](long long) { deposits.increment(); }));
+    printf("gauge.set          %6.2f ns/op\n", nsPerOp(N, [&](long long i) { liveMatrices.set(i); }));
+    printf("histogram.record   %6.2f ns/op\n",
+           nsPerOp(N, [&](long long i) { benchHist.record(static_cast<uint64_t>(i & 0xFFFFF)); }));
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+/*
+
+---------- SHARDED COUNTER ----------
+
+The Counter class in static_members_and_functions.cpp keeps its total in a plain `static int count` and increments it
+with `count++`. That is fine with one thread, but as soon as two threads call increment() at the same time it is a
+data race and increments get lost.
+
+Making count a std::atomic<int> fixes the race, but every increment from every thread now writes the same cache line.
+The line keeps bouncing between cores, and the more threads we add the slower each increment gets.
+
+A sharded counter splits the total into several slots. Each thread increments its own slot, and each slot sits on its
+own cache line so threads never write the same line. Reading the total means summing all slots.
+
+---------- HOW IT WORKS ----------
+
+Shards: A fixed array of cache-line-padded atomic slots, one per thread (threads wrap around if there are more
+        threads than shards).
+increment(): A relaxed fetch_add on the calling thread's slot. With one thread per slot the line stays in that
+             core's cache, so the increment costs about as much as a plain add.
+getCount(): Sums all slots. While other threads are still incrementing the sum is eventually consistent
+            (it never loses increments, it may just not include the newest ones). Once the threads are joined it is exact.
+
+---------- USES ----------
+
+Metrics: Request, error and byte counters updated from many threads.
+Reference Counting: Read-mostly totals where writes vastly outnumber reads.
+Statistics: Instance counters like Counter in static_members_and_functions.cpp.
+
+---------- RULES AND GUIDELINES ----------
+
+Write-Heavy Only: Reads are O(number of shards); use a plain atomic when reads are as frequent as writes.
+Padding: Each slot must be aligned to the cache line size, otherwise neighbouring slots share a line (false sharing).
+Compile: g++ -std=c++17 -O2 -pthread sharded_counter.cpp
+Run: ./a.out [increments per thread, at least 1]
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+class Counter {
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    // One slot per cache line so two threads never write the same line
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        atomic<long long> value{0};
+    };
+
+    static Shard shards[SHARD_COUNT];
+    static atomic<size_t> nextShard;
+
+    // Each thread picks its shard once, round-robin
+    static Shard& localShard() {
+        thread_local size_t index = nextShard.fetch_add(1, memory_order_relaxed) % SHARD_COUNT;
+        return shards[index];
+    }
+
+public:
+    static void increment() {
+        localShard().value.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Exact once all incrementing threads are joined, eventually consistent while they run
+    static long long getCount() {
+        long long total = 0;
+        for (const Shard& s : shards) {
+            total += s.value.load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+    static void reset() {
+        for (Shard& s : shards) {
+            s.value.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+// Definition of the static member variables
+Counter::Shard Counter::shards[Counter::SHARD_COUNT];
+atomic<size_t> Counter::nextShard{0};
+
+// The two alternatives we compare against
+class AtomicCounter {
+private:
+    static atomic<long long> count;  // same width as the sharded total
+
+public:
+    static void increment() { count.fetch_add(1, memory_order_relaxed); }
+    static long long getCount() { return count.load(); }
+    static void reset() { count = 0; }
+};
+
+atomic<long long> AtomicCounter::count{0};
+
+class MutexCounter {
+private:
+    static long long count;
+    static mutex mtx;
+
+public:
+    static void increment() {
+        lock_guard<mutex> lock(mtx);
+        count++;
+    }
+    static long long getCount() {
+        lock_guard<mutex> lock(mtx);
+        return count;
+    }
+    static void reset() { count = 0; }
+};
+
+long long MutexCounter::count = 0;
+mutex MutexCounter::mtx;
+
+// Runs `threads` threads that each increment `perThread` times; returns nanoseconds per increment
+template <typename C>
+double benchmark(int threads, long long perThread, long long& total) {
+    C::reset();
+    atomic<bool> go{false};
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            while (!go.load(memory_order_acquire)) {
+                this_thread::yield();
+            }
+            for (long long i = 0; i < perThread; ++i) {
+                C::increment();
+            }
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    go.store(true, memory_order_release);
+    for (auto& th : pool) {
+        th.join();
+    }
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    total = C::getCount();
+    return elapsed / (static_cast<double>(perThread) * threads);
+}
+
+int main(int argc, char* argv[]) {
+    // Same usage as the original Counter
+    Counter::increment();
+    Counter::increment();
+    cout << "Count after accessing via class name: " << Counter::getCount() << endl;
+
+    // At least 1 (the ns/op figures divide by it), and small enough that 64 threads' total fits in a long long
+    long long perThread = argc > 1 ? min(max(atoll(argv[1]), 1LL), LLONG_MAX / 64) : 200000;
+
+    cout << "\nthreads   sharded ns/op   atomic ns/op   mutex ns/op" << endl;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        long long sharded = 0, atomicTotal = 0, mutexTotal = 0;
+        double s = benchmark<Counter>(threads, perThread, sharded);
+        double a = benchmark<AtomicCounter>(threads, perThread, atomicTotal);
+        double m = benchmark<MutexCounter>(threads, perThread, mutexTotal);
+
+        long long expected = perThread * threads;
+        if (sharded != expected || atomicTotal != expected || mutexTotal != expected) {
+            cerr << "Lost increments with " << threads << " threads" << endl;
+            return 1;
+        }
+
+        printf("%7d %15.2f %14.2f %13.2f\n", threads, s, a, m);
+    }
+
+    return 0;
+}
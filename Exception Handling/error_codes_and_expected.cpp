@@ -0,0 +1,244 @@
+/*
+
+---------- ERROR CODES AND EXPECTED ----------
+
+Division::divide in exception_handling.cpp throws std::runtime_error when the denominator is zero. That is the right
+choice when a zero denominator is truly exceptional, but when it is just common data (a column of measurements with
+some empty samples) exceptions are the wrong tool: every throw allocates the exception object, walks the stack
+looking for a handler and runs the unwinder, which costs microseconds instead of nanoseconds.
+
+The alternative is to return the error as a value:
+
+1. Expected<T, E>: Holds either a result or an error. The caller checks it with `if (result)` and reads the value or
+   the error. Nothing is thrown, nothing is unwound. (C++23 adds std::expected; this is a small C++20 version.)
+2. Batch API with an error mask: divide(num, den, out, errors) divides whole arrays at once. Instead of stopping at
+   the first bad element it writes 0 to out[i] and sets bit i in the errors bitmask, so the loop has no branches and
+   the compiler (or the SIMD code below) can process 2-4 doubles per instruction.
+
+---------- USES ----------
+
+Numeric Pipelines: Divide whole columns where zero denominators are expected data.
+Hot Paths: Report errors without the cost of unwinding.
+Embedded and Real-Time Code: Builds with -fno-exceptions can still report errors.
+Interop: Error codes cross C and language boundaries where exceptions cannot.
+
+---------- RULES AND GUIDELINES ----------
+
+Check Before Use: Reading value() of an Expected that holds an error is a bug (checked with assert here).
+Mask Layout: Bit (i % 64) of errors[i / 64] is set when den[i] == 0; the mask needs (n + 63) / 64 words.
+Sizes Are Checked: The batch divide() returns SizeMismatch, without reading or writing anything, when den or out
+                   differ in length from num or the mask is too short. The check runs in release builds too.
+Keep Exceptions For The Exceptional: Errors that should stop the program belong in exceptions, errors that are just
+                                     data belong in return values.
+Compile: g++ -std=c++20 -O2 error_codes_and_expected.cpp (add -mavx for the 4-wide path)
+
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+enum class DivisionError {
+    DivideByZero,
+    SizeMismatch,
+};
+
+const char* toString(DivisionError e) {
+    switch (e) {
+        case DivisionError::DivideByZero: return "Division by zero error";
+        case DivisionError::SizeMismatch: return "Array sizes do not match";
+    }
+    return "Unknown error";
+}
+
+// Either a value of type T or an error of type E
+template <typename T, typename E>
+class Expected {
+private:
+    std::variant<T, E> storage;
+
+public:
+    Expected(T value) : storage(std::in_place_index<0>, std::move(value)) {}
+    Expected(E error) : storage(std::in_place_index<1>, std::move(error)) {}
+
+    bool hasValue() const noexcept { return storage.index() == 0; }
+    explicit operator bool() const noexcept { return hasValue(); }
+
+    const T& value() const {
+        assert(hasValue());
+        return *std::get_if<0>(&storage);
+    }
+
+    const E& error() const {
+        assert(!hasValue());
+        return *std::get_if<1>(&storage);
+    }
+
+    T valueOr(T fallback) const { return hasValue() ? value() : fallback; }
+};
+
+class Division {
+public:
+    // Original throwing version from exception_handling.cpp
+    static double divide(double numerator, double denominator) {
+        if (denominator == 0) {
+            throw std::runtime_error("Division by zero error");
+        }
+        return numerator / denominator;
+    }
+
+    // Error returned as a value
+    static Expected<double, DivisionError> tryDivide(double numerator, double denominator) noexcept {
+        if (denominator == 0) {
+            return DivisionError::DivideByZero;
+        }
+        return numerator / denominator;
+    }
+
+    // out[i] = num[i] / den[i], or 0 with bit i of errors set when den[i] == 0.
+    // Returns the number of errors, or SizeMismatch (touching nothing) when the spans do not fit together.
+    static Expected<size_t, DivisionError> divide(std::span<const double> num, std::span<const double> den,
+                                                  std::span<double> out, std::span<uint64_t> errors) noexcept {
+        size_t n = num.size();
+        if (den.size() != n || out.size() != n || errors.size() < (n + 63) / 64) {
+            return DivisionError::SizeMismatch;
+        }
+
+        size_t errorCount = 0;
+        for (size_t word = 0; word * 64 < n; ++word) {
+            size_t begin = word * 64;
+            size_t end = begin + 64 < n ? begin + 64 : n;
+            uint64_t mask = divideBlock(num.data(), den.data(), out.data(), begin, end);
+            errors[word] = mask;
+            errorCount += static_cast<size_t>(__builtin_popcountll(mask));
+        }
+        return errorCount;
+    }
+
+private:
+    // Divides [begin, end) (at most 64 elements) and returns the error bits for them
+    static uint64_t divideBlock(const double* num, const double* den, double* out, size_t begin, size_t end) noexcept {
+        uint64_t mask = 0;
+        size_t i = begin;
+
+#if defined(__AVX__)
+        const __m256d zero = _mm256_setzero_pd();
+        for (; i + 4 <= end; i += 4) {
+            __m256d d = _mm256_loadu_pd(den + i);
+            __m256d isZero = _mm256_cmp_pd(d, zero, _CMP_EQ_OQ);
+            // Divide by 1 in the bad lanes so no inf/NaN is produced, then zero those lanes.
+            // and/or instead of blendv: blendv is noticeably slower when the mask is unpredictable.
+            __m256d safe = _mm256_or_pd(_mm256_andnot_pd(isZero, d), _mm256_and_pd(isZero, _mm256_set1_pd(1.0)));
+            __m256d q = _mm256_div_pd(_mm256_loadu_pd(num + i), safe);
+            _mm256_storeu_pd(out + i, _mm256_andnot_pd(isZero, q));
+            mask |= static_cast<uint64_t>(_mm256_movemask_pd(isZero)) << (i - begin);
+        }
+#elif defined(__SSE2__)
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        for (; i + 2 <= end; i += 2) {
+            __m128d d = _mm_loadu_pd(den + i);
+            __m128d isZero = _mm_cmpeq_pd(d, zero);
+            __m128d safe = _mm_or_pd(_mm_andnot_pd(isZero, d), _mm_and_pd(isZero, one));
+            __m128d q = _mm_div_pd(_mm_loadu_pd(num + i), safe);
+            _mm_storeu_pd(out + i, _mm_andnot_pd(isZero, q));
+            mask |= static_cast<uint64_t>(_mm_movemask_pd(isZero)) << (i - begin);
+        }
+#endif
+
+        // Scalar tail (and the whole block on targets without SSE2)
+        for (; i < end; ++i) {
+            bool bad = den[i] == 0;
+            out[i] = bad ? 0.0 : num[i] / den[i];
+            mask |= static_cast<uint64_t>(bad) << (i - begin);
+        }
+        return mask;
+    }
+};
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double nsPerElement(size_t n, int repeats, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        f();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (static_cast<double>(n) * repeats);
+}
+
+int main() {
+    // Same behaviour as exception_handling.cpp, without the throw
+    auto ok = Division::tryDivide(10, 4);
+    auto bad = Division::tryDivide(10, 0);
+    std::cout << "10 / 4 = " << ok.value() << std::endl;
+    if (!bad) {
+        std::cerr << "Error: " << toString(bad.error()) << std::endl;
+    }
+
+    const size_t n = 1 << 16;
+    std::vector<double> num(n), den(n), outThrow(n), outExpected(n), outBatch(n);
+    std::vector<uint64_t> errors((n + 63) / 64);
+
+    auto mismatch = Division::divide(num, std::span<const double>(den).first(n - 1), outBatch, errors);
+    if (!mismatch) {
+        std::cerr << "Batch error: " << toString(mismatch.error()) << std::endl;
+    }
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> value(1.0, 100.0);
+
+    std::printf("\nerror rate   throw ns/elem   expected ns/elem   batch ns/elem\n");
+    for (double errorRate : {0.0, 0.01, 0.5}) {
+        std::bernoulli_distribution isZero(errorRate);
+        for (size_t i = 0; i < n; ++i) {
+            num[i] = value(rng);
+            den[i] = isZero(rng) ? 0.0 : value(rng);
+        }
+
+        // Fewer repeats for the throwing path: at 50% errors it is orders of magnitude slower
+        int throwRepeats = errorRate > 0.1 ? 2 : 20;
+        double tThrow = nsPerElement(n, throwRepeats, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                try {
+                    outThrow[i] = Division::divide(num[i], den[i]);
+                } catch (const std::runtime_error&) {
+                    outThrow[i] = 0.0;
+                }
+            }
+        });
+
+        double tExpected = nsPerElement(n, 20, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                outExpected[i] = Division::tryDivide(num[i], den[i]).valueOr(0.0);
+            }
+        });
+
+        size_t errorCount = 0;
+        double tBatch = nsPerElement(n, 20, [&] {
+            errorCount = Division::divide(num, den, outBatch, errors).valueOr(0);
+        });
+
+        if (outThrow != outExpected || outExpected != outBatch) {
+            std::cerr << "Results differ" << std::endl;
+            return 1;
+        }
+
+        std::printf("%9.0f%% %15.2f %18.2f %15.2f   (%zu errors)\n", errorRate * 100, tThrow, tExpected, tBatch,
+                    errorCount);
+    }
+
+    return 0;
+}
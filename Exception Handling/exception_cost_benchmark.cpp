@@ -0,0 +1,203 @@
+/*
+
+---------- EXCEPTION COST BENCHMARK ----------
+
+exception_handling.cpp throws when it divides by zero, and the Matrix, Simple and SmartPtr classes rely on their
+destructors running when the stack unwinds. Both are free on the happy path with modern "zero-cost" exceptions:
+no extra instructions run until something is thrown. The cost is paid when a throw happens:
+
+1. The exception object is allocated (__cxa_allocate_exception).
+2. The unwinder searches the call stack frame by frame for a matching catch block, using the unwind tables.
+3. A second pass walks the same frames again, running the destructor of every live RAII object (the landing pads).
+
+So the cost of a throw grows with the number of frames between throw and catch and with the number of objects that
+must be destroyed on the way. This benchmark measures exactly that, next to the same work done with an error code,
+and reports the binary size cost of keeping exceptions enabled.
+
+---------- WHAT IS MEASURED ----------
+
+throw_catch: Throw at the bottom of `depth` nested calls, each frame holding `raii` live objects, catch at the top.
+error_code: Same call chain and objects, but the failure is returned as a bool through every frame.
+binary_size: With --size, the program recompiles itself twice, with and without -fno-exceptions, and reports both
+             sizes. Both builds define SIZE_PROBE, which leaves out the throw_catch benchmark, so they contain the
+             same code and the difference is only the unwind tables and landing pads that exceptions need.
+
+---------- OUTPUT ----------
+
+One JSON object on stdout so the results can be stored and compared between builds:
+{"compiler": "...", "exceptions": true, "results": [{"benchmark": "throw_catch", "depth": 4, "raii": 1, "ns": 812.4}, ...]}
+With --size the document also has
+"binary_size": {"code": "error_code benchmarks only", "exceptions": 23016, "no_exceptions": 22920}
+
+---------- RULES AND GUIDELINES ----------
+
+Exceptions For Rare Events: A throw costs around a microsecond or more; use return values for frequent failures
+                            (see error_codes_and_expected.cpp).
+Shallow Catch: Catching close to the throw keeps the unwinder's work small.
+Compile: g++ -std=c++17 -O2 exception_cost_benchmark.cpp
+         g++ -std=c++17 -O2 -fno-exceptions exception_cost_benchmark.cpp   (error_code rows only)
+Run: ./a.out [--size [--source PATH]]   (CXX selects the compiler used by --size, default g++; the source is found
+     through __FILE__, relative to where the program was compiled, so pass --source when running elsewhere. If the
+     probe builds fail, the error goes to stderr and the exit status is 1.)
+
+*/
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(__cpp_exceptions)
+#include <stdexcept>
+constexpr bool EXCEPTIONS_ENABLED = true;
+#else
+constexpr bool EXCEPTIONS_ENABLED = false;
+#endif
+
+// A destructor the optimizer cannot remove, standing in for Matrix/Simple/SmartPtr
+static volatile long destroyed = 0;
+
+struct Guard {
+    ~Guard() { destroyed = destroyed + 1; }
+};
+
+// SIZE_PROBE (set by --size) leaves out the throwing code so that builds with and without exceptions compare the
+// same program
+#if defined(__cpp_exceptions) && !defined(SIZE_PROBE)
+
+template <size_t Raii>
+__attribute__((noinline)) int throwingChain(int depth) {
+    std::array<Guard, Raii> guards;
+    (void)guards;
+    if (depth == 0) {
+        throw std::runtime_error("Division by zero error");
+    }
+    return throwingChain<Raii>(depth - 1) + 1;
+}
+
+#endif
+
+template <size_t Raii>
+__attribute__((noinline)) bool errorChain(int depth, int& result) {
+    std::array<Guard, Raii> guards;
+    (void)guards;
+    if (depth == 0) {
+        return false;
+    }
+    if (!errorChain<Raii>(depth - 1, result)) {
+        return false;
+    }
+    result += 1;
+    return true;
+}
+
+struct Result {
+    const char* benchmark;
+    int depth;
+    size_t raii;
+    double ns;
+};
+
+template <typename F>
+double nsPerOp(int iterations, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+template <size_t Raii>
+void measure(std::vector<Result>& results) {
+    for (int depth : {0, 1, 4, 16, 64}) {
+#if defined(__cpp_exceptions) && !defined(SIZE_PROBE)
+        double t = nsPerOp(5000, [depth] {
+            try {
+                throwingChain<Raii>(depth);
+            } catch (const std::runtime_error&) {
+            }
+        });
+        results.push_back({"throw_catch", depth, Raii, t});
+#endif
+        double e = nsPerOp(20000, [depth] {
+            int r = 0;
+            errorChain<Raii>(depth, r);
+        });
+        results.push_back({"error_code", depth, Raii, e});
+    }
+}
+
+// Compiles the source once with the given flags and returns the binary size, or -1 when the build fails
+static long long compiledSize(const std::string& source, const std::string& extraFlags) {
+    const char* cxx = std::getenv("CXX");
+    std::string out = std::filesystem::temp_directory_path() / "exception_cost_size_probe";
+    std::string cmd = std::string(cxx ? cxx : "g++") + " -std=c++17 -O2 -s -DSIZE_PROBE " + extraFlags + " \"" +
+                      source + "\" -o \"" + out + "\" 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        return -1;
+    }
+    std::error_code ec;
+    auto size = std::filesystem::file_size(out, ec);
+    std::filesystem::remove(out, ec);
+    return ec ? -1 : static_cast<long long>(size);
+}
+
+int main(int argc, char* argv[]) {
+    bool sizeReport = false;
+    std::string source = __FILE__;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size") {
+            sizeReport = true;
+        } else if (arg == "--source" && i + 1 < argc) {
+            source = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--size [--source PATH]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    measure<0>(results);
+    measure<1>(results);
+    measure<4>(results);
+    measure<16>(results);
+
+    std::printf("{\"compiler\": \"%s\", \"exceptions\": %s, \"results\": [\n", __VERSION__,
+                EXCEPTIONS_ENABLED ? "true" : "false");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::printf("  {\"benchmark\": \"%s\", \"depth\": %d, \"raii\": %zu, \"ns\": %.1f}%s\n", r.benchmark, r.depth,
+                    r.raii, r.ns, i + 1 < results.size() ? "," : "");
+    }
+    std::printf("]");
+
+    bool sizeFailed = false;
+    if (sizeReport) {
+        long long with = -1, without = -1;
+        if (!std::filesystem::exists(source)) {
+            std::fprintf(stderr, "source file %s not found (it is relative to where the program was compiled); "
+                                 "pass --source PATH\n", source.c_str());
+        } else {
+            with = compiledSize(source, "");
+            without = compiledSize(source, "-fno-exceptions");
+            if (with < 0 || without < 0) {
+                std::fprintf(stderr, "could not compile %s for the size report\n", source.c_str());
+            }
+        }
+        sizeFailed = with < 0 || without < 0;
+        if (sizeFailed) {
+            std::printf(", \"binary_size\": null");
+        } else {
+            std::printf(", \"binary_size\": {\"code\": \"error_code benchmarks only\", \"exceptions\": %lld, "
+                        "\"no_exceptions\": %lld}",
+                        with, without);
+        }
+    }
+    std::printf("}\n");
+
+    return sizeFailed ? 1 : 0;
+}
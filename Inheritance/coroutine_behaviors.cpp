@@ -0,0 +1,636 @@
+/*
+
+---------- COROUTINE BEHAVIORS ----------
+
+Dog::bark(), Cat::meow() and Bird::fly() in hierarchical_inheritance.cpp print and return at once. Real behaviors
+wait: a dog barks when the doorbell rings, a bird flies again after resting for a while. Written as ordinary
+functions, every waiting behavior holds a thread (and its stack of megabytes) while doing nothing, so a million
+waiting animals would need a million threads.
+
+A C++20 coroutine is a function that can suspend at a co_await and be resumed later. Its local variables live in a
+heap-allocated frame of a few dozen bytes instead of on a thread's stack, so millions of them can wait at the same
+time and a handful of threads resumes whichever is ready.
+
+---------- HOW IT WORKS ----------
+
+Task<T>: The coroutine type. It is lazy (it starts only when awaited) and co_await task runs it and returns its
+         result or rethrows its exception. A task that finishes without suspending returns straight into its awaiter;
+         one that suspended resumes its awaiter when it finishes, on whichever thread finished it. An atomic
+         handshake decides which case happened, so a loop over a million awaits runs in constant stack at any
+         optimization level. (Returning the awaiter's handle from final_suspend, "symmetric transfer", only does that
+         when the compiler turns the resume into a tail call, which GCC does not at -O0 or under AddressSanitizer.)
+EventLoop: Single-threaded. Keeps a queue of ready coroutines, a heap of timers (sleepFor) and a list of file
+           descriptors being waited on (readable), and resumes coroutines as they become ready, using poll() to sleep
+           until the next timer or I/O event.
+ThreadPoolExecutor: Multi-threaded. co_await executor.schedule() moves the coroutine onto one of the pool's threads.
+spawn(task): Starts a Task<void> detached on a loop or executor; run() / wait() return when all spawned tasks are done.
+Frame Accounting: The promise type has its own operator new, so the number and size of live coroutine frames are
+                  known exactly.
+
+---------- RULES AND GUIDELINES ----------
+
+References In Parameters Dangle: A coroutine outlives the caller's statement, so take parameters by value unless the
+                                 referenced object surely outlives the coroutine (like the event loop here). The
+                                 same holds for the captures of a lambda that is a coroutine.
+Never Block Inside A Coroutine: sleep_for or a blocking read stops every coroutine on that thread; co_await instead.
+One Owner Per Task: A Task is move-only and destroys its frame; spawn() transfers it to the scheduler.
+Compile: g++ -std=c++20 -O2 -pthread coroutine_behaviors.cpp
+Run: ./a.out [suspended behaviors, default 1000000, at least 1]
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <poll.h>
+#include <pthread.h>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+
+// ---------- FRAME ACCOUNTING ----------
+
+inline atomic<long> liveFrames{0};
+inline atomic<long> liveFrameBytes{0};
+
+// Kept out of line: when GCC 12 inlines the frame allocation into a coroutine it wrongly reports
+// -Wmismatched-new-delete
+[[gnu::noinline]] void* allocateFrame(size_t bytes) {
+    liveFrames.fetch_add(1, memory_order_relaxed);
+    liveFrameBytes.fetch_add(static_cast<long>(bytes), memory_order_relaxed);
+    return ::operator new(bytes);
+}
+
+[[gnu::noinline]] void freeFrame(void* p, size_t bytes) {
+    liveFrames.fetch_sub(1, memory_order_relaxed);
+    liveFrameBytes.fetch_sub(static_cast<long>(bytes), memory_order_relaxed);
+    ::operator delete(p);
+}
+
+// Base for promise types: coroutine frames are allocated through these
+struct CountedFrame {
+    static void* operator new(size_t bytes) { return allocateFrame(bytes); }
+    static void operator delete(void* p, size_t bytes) { freeFrame(p, bytes); }
+};
+
+// ---------- TASK ----------
+
+template <typename T = void>
+class Task;
+
+struct TaskPromiseBase : CountedFrame {
+    coroutine_handle<> continuation;
+    exception_ptr error;
+
+    // Set by whichever of awaiter and task gets there second: the awaiter after starting the task, the task when it
+    // finishes. The second one knows the awaiter must continue.
+    atomic<bool> handshake{false};
+
+    // Resumes the awaiter only if it already suspended; a task that finished inline just returns into it
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        coroutine_handle<> await_suspend(coroutine_handle<Promise> h) noexcept {
+            TaskPromiseBase& p = h.promise();
+            return p.handshake.exchange(true, memory_order_acq_rel) ? p.continuation : noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(forward<U>(v));
+    }
+    T result() {
+        if (error) {
+            rethrow_exception(error);
+        }
+        return move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+};
+
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            coroutine_handle<promise_type> handle;
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            // Runs the task up to its first suspension; stays suspended only if the task has not finished
+            bool await_suspend(coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                handle.resume();
+                return !handle.promise().handshake.exchange(true, memory_order_acq_rel);
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// A fire-and-forget coroutine that frees itself when it finishes; used by spawn()
+struct Detached {
+    struct promise_type : CountedFrame {
+        Detached get_return_object() { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+template <typename Scheduler>
+Detached runDetached(Scheduler& scheduler, Task<void> task) {
+    co_await scheduler.schedule();
+    try {
+        co_await task;
+    } catch (const exception& e) {
+        cerr << "behavior failed: " << e.what() << endl;
+    }
+    scheduler.taskFinished();
+}
+
+// ---------- SINGLE-THREADED EVENT LOOP ----------
+
+class EventLoop {
+private:
+    using Clock = chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point when;
+        uint64_t sequence;  // FIFO order among equal deadlines
+        coroutine_handle<> handle;
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : sequence > other.sequence;
+        }
+    };
+
+    struct IoWait {
+        int fd;
+        coroutine_handle<> handle;
+    };
+
+    deque<coroutine_handle<>> ready;
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+    vector<IoWait> ioWaits;
+    uint64_t timerSequence = 0;
+    size_t live = 0;  // spawned tasks not yet finished
+
+    void pollIo(int timeoutMs) {
+        vector<pollfd> fds;
+        for (const IoWait& w : ioWaits) {
+            fds.push_back({w.fd, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), timeoutMs) <= 0) {
+            return;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < ioWaits.size(); ++i) {
+            if (fds[i].revents) {
+                ready.push_back(ioWaits[i].handle);
+            } else {
+                ioWaits[kept++] = ioWaits[i];
+            }
+        }
+        ioWaits.resize(kept);
+    }
+
+public:
+    // Suspends and requeues the coroutine behind everything already ready
+    auto schedule() {
+        struct Awaiter {
+            EventLoop& loop;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { loop.ready.push_back(h); }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    auto yield() { return schedule(); }
+
+    auto sleepFor(Clock::duration d) {
+        struct Awaiter {
+            EventLoop& loop;
+            Clock::duration d;
+            bool await_ready() noexcept { return d <= Clock::duration::zero(); }
+            void await_suspend(coroutine_handle<> h) { loop.timers.push({Clock::now() + d, loop.timerSequence++, h}); }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{*this, d};
+    }
+
+    // Resumes when fd has data to read
+    auto readable(int fd) {
+        struct Awaiter {
+            EventLoop& loop;
+            int fd;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { loop.ioWaits.push_back({fd, h}); }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{*this, fd};
+    }
+
+    void spawn(Task<void> task) {
+        ++live;
+        runDetached(*this, move(task));
+    }
+
+    void taskFinished() { --live; }
+
+    size_t pendingTimers() const { return timers.size(); }
+
+    // Runs until every spawned task has finished
+    void run() {
+        while (live > 0) {
+            auto now = Clock::now();
+            while (!timers.empty() && timers.top().when <= now) {
+                ready.push_back(timers.top().handle);
+                timers.pop();
+            }
+            if (!ioWaits.empty()) {
+                int timeoutMs = -1;
+                if (!ready.empty()) {
+                    timeoutMs = 0;
+                } else if (!timers.empty()) {
+                    auto wait = chrono::ceil<chrono::milliseconds>(timers.top().when - now);
+                    timeoutMs = static_cast<int>(wait.count());
+                }
+                pollIo(timeoutMs);
+            }
+            if (ready.empty()) {
+                if (timers.empty() && ioWaits.empty()) {
+                    throw logic_error("every task is waiting for something that will never happen");
+                }
+                if (ioWaits.empty()) {
+                    this_thread::sleep_until(timers.top().when);
+                }
+                continue;
+            }
+            // Only what is ready now, so timers and I/O get a turn between rounds
+            for (size_t n = ready.size(); n > 0; --n) {
+                coroutine_handle<> h = ready.front();
+                ready.pop_front();
+                h.resume();
+            }
+        }
+    }
+};
+
+// ---------- MULTI-THREADED EXECUTOR ----------
+
+class ThreadPoolExecutor {
+private:
+    mutex m;
+    condition_variable available;
+    condition_variable idle;
+    deque<coroutine_handle<>> queue;
+    vector<thread> threads;
+    bool stopping = false;
+    atomic<size_t> live{0};
+
+    void post(coroutine_handle<> h) {
+        {
+            lock_guard<mutex> lock(m);
+            queue.push_back(h);
+        }
+        available.notify_one();
+    }
+
+    void workerLoop() {
+        for (;;) {
+            coroutine_handle<> h;
+            {
+                unique_lock<mutex> lock(m);
+                available.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                h = queue.front();
+                queue.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+public:
+    explicit ThreadPoolExecutor(unsigned threadCount) {
+        for (unsigned i = 0; i < max(1u, threadCount); ++i) {
+            threads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPoolExecutor() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        available.notify_all();
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+
+    // Continues the coroutine on one of the pool's threads
+    auto schedule() {
+        struct Awaiter {
+            ThreadPoolExecutor& executor;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { executor.post(h); }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    void spawn(Task<void> task) {
+        live.fetch_add(1);
+        runDetached(*this, move(task));
+    }
+
+    void taskFinished() {
+        if (live.fetch_sub(1) == 1) {
+            lock_guard<mutex> lock(m);
+            idle.notify_all();
+        }
+    }
+
+    // Blocks until every spawned task has finished
+    void wait() {
+        unique_lock<mutex> lock(m);
+        idle.wait(lock, [&] { return live.load() == 0; });
+    }
+};
+
+// ---------- ANIMAL BEHAVIORS ----------
+
+Task<int> findFood(EventLoop& loop, int grams) {
+    co_await loop.sleepFor(20ms);  // walking to the bowl
+    co_return grams;
+}
+
+Task<void> eat(EventLoop& loop, string name) {
+    int grams = co_await findFood(loop, 150);
+    cout << name << " is eating " << grams << " g." << endl;
+}
+
+Task<void> barkAtDoorbell(EventLoop& loop, int doorbell) {
+    co_await loop.readable(doorbell);
+    char ring;
+    if (read(doorbell, &ring, 1) == 1) {
+        cout << "Dog is barking at the door." << endl;
+    }
+}
+
+Task<void> meow(EventLoop& loop, int times) {
+    for (int i = 0; i < times; ++i) {
+        co_await loop.sleepFor(15ms);
+        cout << "Cat is meowing." << endl;
+    }
+}
+
+Task<void> fly(EventLoop& loop, int flights) {
+    for (int i = 0; i < flights; ++i) {
+        cout << "Bird is flying." << endl;
+        co_await loop.sleepFor(25ms);  // resting
+    }
+}
+
+Task<void> ringDoorbell(EventLoop& loop, int bell) {
+    co_await loop.sleepFor(40ms);
+    cout << "(ding dong)" << endl;
+    if (write(bell, "!", 1) != 1) {
+        throw runtime_error("doorbell is broken");
+    }
+}
+
+// ---------- BENCHMARK ----------
+
+Task<int> leaf(int x) { co_return x + 1; }
+
+Task<long> sumOfLeaves(int n) {
+    long sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += co_await leaf(i);
+    }
+    co_return sum;
+}
+
+Task<void> yielder(EventLoop& loop, int times) {
+    for (int i = 0; i < times; ++i) {
+        co_await loop.yield();
+    }
+}
+
+Task<void> hopper(ThreadPoolExecutor& executor, int hops) {
+    for (int i = 0; i < hops; ++i) {
+        co_await executor.schedule();
+    }
+}
+
+Task<void> waitAndCount(EventLoop& loop, chrono::milliseconds d, long& woken) {
+    co_await loop.sleepFor(d);
+    ++woken;
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// argv[index] as an integer clamped to [lo, hi], or fallback when it is absent
+static long long argument(int argc, char* argv[], int index, long long fallback, long long lo, long long hi) {
+    long long value = argc > index ? strtoll(argv[index], nullptr, 10) : fallback;
+    return min(max(value, lo), hi);
+}
+
+int main(int argc, char* argv[]) {
+    // Behaviors waiting on timers and on I/O, interleaved on one thread
+    {
+        int bell[2];
+        if (pipe(bell) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        EventLoop loop;
+        loop.spawn(barkAtDoorbell(loop, bell[0]));
+        loop.spawn(meow(loop, 3));
+        loop.spawn(fly(loop, 2));
+        loop.spawn(eat(loop, "Cat"));
+        loop.spawn(ringDoorbell(loop, bell[1]));
+        loop.run();
+        close(bell[0]);
+        close(bell[1]);
+    }
+
+    const long n = static_cast<long>(argument(argc, argv, 1, 1000000, 1, LONG_MAX));
+
+    // 1. Creation: create, run and destroy a coroutine
+    {
+        const int count = 1000000;
+        auto start = chrono::steady_clock::now();
+        long sum = 0;
+        [&]() -> Detached {
+            sum = co_await sumOfLeaves(count);
+        }();
+        double coroutineNs = secondsSince(start) * 1e9 / count;
+
+        const int threadCount = 1000;
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < threadCount; ++i) {
+            thread([&sum] { ++sum; }).join();
+        }
+        double threadNs = secondsSince(start) * 1e9 / threadCount;
+        volatile long sink = sum;  // keeps the work from being optimized away
+        (void)sink;
+        printf("\ncreate + run + destroy:  coroutine %8.1f ns   thread %10.1f ns\n", coroutineNs, threadNs);
+    }
+
+    // 2. Suspend/resume on one thread, against handing off between two threads
+    {
+        const int tasks = 1000, yields = 1000;
+        EventLoop loop;
+        for (int i = 0; i < tasks; ++i) {
+            loop.spawn(yielder(loop, yields));
+        }
+        auto start = chrono::steady_clock::now();
+        loop.run();
+        double loopNs = secondsSince(start) * 1e9 / (double(tasks) * yields);
+
+        const int hops = 100000;
+        ThreadPoolExecutor executor(thread::hardware_concurrency());
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < 100; ++i) {
+            executor.spawn(hopper(executor, hops / 100));
+        }
+        executor.wait();
+        double executorNs = secondsSince(start) * 1e9 / hops;
+
+        const int pings = 20000;
+        mutex m;
+        condition_variable cv;
+        int turn = 0;
+        start = chrono::steady_clock::now();
+        thread other([&] {
+            for (int i = 0; i < pings; ++i) {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&] { return turn == 1; });
+                turn = 0;
+                cv.notify_one();
+            }
+        });
+        for (int i = 0; i < pings; ++i) {
+            unique_lock<mutex> lock(m);
+            turn = 1;
+            cv.notify_one();
+            cv.wait(lock, [&] { return turn == 0; });
+        }
+        other.join();
+        double threadNs = secondsSince(start) * 1e9 / (2.0 * pings);
+
+        printf("suspend + resume:        event loop %6.1f ns   executor hop %8.1f ns   thread handoff %8.1f ns\n",
+               loopNs, executorNs, threadNs);
+    }
+
+    // 3. Memory: n behaviors suspended on timers at the same time
+    {
+        EventLoop loop;
+        long woken = 0, framesWhileWaiting = 0, bytesWhileWaiting = 0;
+        size_t timersWhileWaiting = 0;
+        long framesBefore = liveFrames.load(), bytesBefore = liveFrameBytes.load();
+        for (long i = 0; i < n; ++i) {
+            loop.spawn(waitAndCount(loop, 200ms, woken));
+        }
+        // Spawned last, so it runs once every behavior has reached its sleepFor. A lambda coroutine reaches its
+        // captures through the closure, so the closure must outlive the coroutine: it is a named local, not a temporary.
+        auto observe = [&]() -> Task<void> {
+            framesWhileWaiting = liveFrames.load() - framesBefore;
+            bytesWhileWaiting = liveFrameBytes.load() - bytesBefore;
+            timersWhileWaiting = loop.pendingTimers();
+            co_return;
+        };
+        loop.spawn(observe());
+        auto start = chrono::steady_clock::now();
+        loop.run();
+        double seconds = secondsSince(start);
+
+        pthread_attr_t attr;
+        size_t stack = 0;
+        pthread_attr_init(&attr);
+        pthread_attr_getstacksize(&attr, &stack);
+        pthread_attr_destroy(&attr);
+
+        double perTask = double(bytesWhileWaiting) / n + double(sizeof(void*) * 4);  // frames + timer heap entry
+        printf("%ld suspended behaviors: %ld frames, %.1f MB of frames, %zu timers, ~%.0f bytes each "
+               "(a thread reserves %zu KB of stack)\n",
+               n, framesWhileWaiting, bytesWhileWaiting / 1e6, timersWhileWaiting, perTask, stack / 1024);
+        printf("all %ld woke up and finished in %.2f s (200 ms of it sleeping)\n", woken, seconds);
+    }
+
+    return 0;
+}
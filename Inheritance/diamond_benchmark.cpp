@@ -0,0 +1,325 @@
+/*
+
+---------- COST OF THE DIAMOND ----------
+
+diamond_problem.cpp solves the diamond with virtual inheritance: B and C inherit `virtual public A`, so D holds one
+shared A. The price is paid at run time, because the position of the shared A inside an object is no longer fixed:
+
+1. Member Access: Code that sees only a B& (a function taking B&, a B* in a container) does not know where A starts.
+   It loads the "virtual base offset" from the object's vtable, then adds it: two dependent loads instead of one.
+2. Construction: Every constructor takes a hidden "construct the virtual base or not" decision (and the most derived
+   class constructs A itself), and each class writes extra vtable pointers (construction vtables).
+3. Casts: Converting B* to A* reads the offset from the vtable. Casting down or across (A* -> D*, B* -> C*) is not
+   possible with static_cast at all and needs dynamic_cast.
+
+This file measures those costs for three layouts of the same diamond:
+
+Virtual: class B : virtual public A, class C : virtual public A, class D : public B, public C (diamond_problem.cpp).
+Non-Virtual: class B : public A, class C : public A. D contains two A's; code must say which one it means.
+Mixin (CRTP): D inherits A once, normally, plus BPolicy<D> and CPolicy<D>. The policies hold B's and C's state and
+              reach A through static_cast<D&>(*this), which the compiler resolves to a fixed offset at compile time.
+              MixinD in diamond_problem.cpp prints exactly what the virtual D prints.
+
+---------- RULES AND GUIDELINES ----------
+
+Virtual Inheritance Is For Shared State: Keep it where one A really must be shared by independently written B and C.
+Hot Loops Prefer Fixed Layouts: When B and C are written together with D, the mixin layout gives the same single A
+                                with no offset lookups and no dynamic_cast.
+Every A Has A Virtual Destructor: Like any polymorphic base, and needed for dynamic_cast in the cast benchmarks.
+Compile: g++ -std=c++17 -O2 diamond_benchmark.cpp
+
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+static bool traceConstruction = false;  // the constructors print like diamond_problem.cpp when enabled
+
+// ---------- VIRTUAL DIAMOND (diamond_problem.cpp) ----------
+
+namespace virtual_diamond {
+
+class A {
+public:
+    int value = 1;
+    A() { if (traceConstruction) cout << "A's constructor\n"; }
+    virtual ~A() = default;
+};
+
+class B : virtual public A {
+public:
+    int b = 2;
+    B() { if (traceConstruction) cout << "B's constructor\n"; }
+    void bumpFromB() { value += b; }
+};
+
+class C : virtual public A {
+public:
+    int c = 3;
+    C() { if (traceConstruction) cout << "C's constructor\n"; }
+};
+
+class D : public B, public C {
+public:
+    D() { if (traceConstruction) cout << "D's constructor\n"; }
+};
+
+}  // namespace virtual_diamond
+
+// ---------- NON-VIRTUAL DIAMOND (two copies of A) ----------
+
+namespace plain_diamond {
+
+class A {
+public:
+    int value = 1;
+    A() { if (traceConstruction) cout << "A's constructor\n"; }
+    virtual ~A() = default;
+};
+
+class B : public A {
+public:
+    int b = 2;
+    B() { if (traceConstruction) cout << "B's constructor\n"; }
+    void bumpFromB() { value += b; }
+};
+
+class C : public A {
+public:
+    int c = 3;
+    C() { if (traceConstruction) cout << "C's constructor\n"; }
+};
+
+class D : public B, public C {
+public:
+    D() { if (traceConstruction) cout << "D's constructor\n"; }
+};
+
+}  // namespace plain_diamond
+
+// ---------- MIXIN DIAMOND (CRTP policies) ----------
+
+namespace mixin_diamond {
+
+class A {
+public:
+    int value = 1;
+    A() { if (traceConstruction) cout << "A's constructor\n"; }
+    virtual ~A() = default;
+};
+
+template <typename Derived>
+class BPolicy {
+public:
+    int b = 2;
+    BPolicy() { if (traceConstruction) cout << "B's constructor\n"; }
+    void bumpFromB() { derived().value += b; }
+
+protected:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+template <typename Derived>
+class CPolicy {
+public:
+    int c = 3;
+    CPolicy() { if (traceConstruction) cout << "C's constructor\n"; }
+
+protected:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+class D : public A, public BPolicy<D>, public CPolicy<D> {
+public:
+    D() { if (traceConstruction) cout << "D's constructor\n"; }
+};
+
+using B = BPolicy<D>;
+using C = CPolicy<D>;
+
+}  // namespace mixin_diamond
+
+// ---------- OPERATIONS (noinline, so the compiler only sees a B*, as in real code) ----------
+
+namespace virtual_diamond {
+A* baseOf(D* d) { return d; }
+__attribute__((noinline)) long sumA(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += items[i]->value;  // A's member through B*: offset from the vtable
+    return sum;
+}
+__attribute__((noinline)) void bump(B* const* items, size_t n) {
+    for (size_t i = 0; i < n; ++i) items[i]->bumpFromB();
+}
+__attribute__((noinline)) long upcast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += reinterpret_cast<long>(static_cast<A*>(items[i]));
+    return sum;
+}
+__attribute__((noinline)) long crosscast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += dynamic_cast<C*>(items[i])->c;  // static_cast cannot cross
+    return sum;
+}
+__attribute__((noinline)) long downcast(A* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += dynamic_cast<D*>(items[i])->c;  // static_cast from a virtual base is ill-formed
+    return sum;
+}
+}  // namespace virtual_diamond
+
+namespace plain_diamond {
+A* baseOf(D* d) { return static_cast<B*>(d); }  // the A inside B
+__attribute__((noinline)) long sumA(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += items[i]->value;
+    return sum;
+}
+__attribute__((noinline)) void bump(B* const* items, size_t n) {
+    for (size_t i = 0; i < n; ++i) items[i]->bumpFromB();
+}
+__attribute__((noinline)) long upcast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += reinterpret_cast<long>(static_cast<A*>(items[i]));
+    return sum;
+}
+__attribute__((noinline)) long crosscast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<C*>(static_cast<D*>(items[i]))->c;
+    return sum;
+}
+__attribute__((noinline)) long downcast(A* const* items, size_t n) {
+    long sum = 0;  // items point at the A inside B, so the cast goes through B
+    for (size_t i = 0; i < n; ++i) sum += static_cast<D*>(static_cast<B*>(items[i]))->c;
+    return sum;
+}
+}  // namespace plain_diamond
+
+namespace mixin_diamond {
+A* baseOf(D* d) { return d; }
+__attribute__((noinline)) long sumA(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<D*>(items[i])->value;  // fixed offset
+    return sum;
+}
+__attribute__((noinline)) void bump(B* const* items, size_t n) {
+    for (size_t i = 0; i < n; ++i) items[i]->bumpFromB();
+}
+__attribute__((noinline)) long upcast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += reinterpret_cast<long>(static_cast<A*>(static_cast<D*>(items[i])));
+    return sum;
+}
+__attribute__((noinline)) long crosscast(B* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<C*>(static_cast<D*>(items[i]))->c;
+    return sum;
+}
+__attribute__((noinline)) long downcast(A* const* items, size_t n) {
+    long sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<D*>(items[i])->c;
+    return sum;
+}
+}  // namespace mixin_diamond
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double nsPerItem(size_t n, int repeats, F&& f) {
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        f();
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (double(n) * repeats);
+}
+
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Results {
+    double access, bump, construct, upcast, crosscast, downcast;
+    size_t size;
+    long checksum;
+};
+
+template <typename D, typename A, typename B, typename Ops>
+Results run(size_t n, Ops ops) {
+    Results r{};
+    r.size = sizeof(D);
+    const int repeats = 20;
+
+    // Construction into preallocated storage, so only the constructors are timed
+    unique_ptr<unsigned char[]> storage(new unsigned char[n * sizeof(D) + alignof(D)]);
+    D* raw = reinterpret_cast<D*>(storage.get());
+    r.construct = nsPerItem(n, repeats, [&] {
+        for (size_t i = 0; i < n; ++i) new (raw + i) D();
+        keep(raw[n - 1]);
+        for (size_t i = 0; i < n; ++i) raw[i].~D();
+    });
+
+    vector<D> objects(n);
+    vector<B*> asB(n);
+    vector<A*> asA(n);
+    for (size_t i = 0; i < n; ++i) {
+        asB[i] = &objects[i];
+        asA[i] = ops.baseOf(&objects[i]);
+    }
+
+    long sum = 0;
+    r.access = nsPerItem(n, repeats, [&] { sum += ops.sumA(asB.data(), n); });
+    r.bump = nsPerItem(n, repeats, [&] { ops.bump(asB.data(), n); });
+    r.upcast = nsPerItem(n, repeats, [&] { sum += ops.upcast(asB.data(), n) != 0; });
+    r.crosscast = nsPerItem(n, repeats, [&] { sum += ops.crosscast(asB.data(), n); });
+    r.downcast = nsPerItem(n, repeats, [&] { sum += ops.downcast(asA.data(), n); });
+    r.checksum = sum;
+    return r;
+}
+
+#define OPS(ns)                                                                         \
+    struct {                                                                            \
+        long sumA(ns::B* const* p, size_t n) const { return ns::sumA(p, n); }           \
+        void bump(ns::B* const* p, size_t n) const { ns::bump(p, n); }                  \
+        long upcast(ns::B* const* p, size_t n) const { return ns::upcast(p, n); }       \
+        long crosscast(ns::B* const* p, size_t n) const { return ns::crosscast(p, n); } \
+        long downcast(ns::A* const* p, size_t n) const { return ns::downcast(p, n); }   \
+        ns::A* baseOf(ns::D* d) const { return ns::baseOf(d); }                         \
+    }
+
+int main() {
+    // The mixin D behaves like the virtual D of diamond_problem.cpp
+    traceConstruction = true;
+    cout << "virtual D:" << endl;
+    { virtual_diamond::D d; }
+    cout << "mixin D:" << endl;
+    { mixin_diamond::D d; }
+    traceConstruction = false;
+
+    const size_t n = 1 << 16;  // fits in L2, so the layout rather than memory bandwidth is measured
+    using VOps = OPS(virtual_diamond);
+    using POps = OPS(plain_diamond);
+    using MOps = OPS(mixin_diamond);
+    Results v = run<virtual_diamond::D, virtual_diamond::A, virtual_diamond::B>(n, VOps());
+    Results p = run<plain_diamond::D, plain_diamond::A, plain_diamond::B>(n, POps());
+    Results m = run<mixin_diamond::D, mixin_diamond::A, mixin_diamond::B>(n, MOps());
+
+    printf("\n%-28s %10s %12s %10s\n", "ns per object", "virtual", "non-virtual", "mixin");
+    printf("%-28s %10zu %12zu %10zu\n", "sizeof(D)", v.size, p.size, m.size);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "read A::value through B*", v.access, p.access, m.access);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "B::bumpFromB (writes A)", v.bump, p.bump, m.bump);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "construct + destroy D", v.construct, p.construct, m.construct);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "upcast B* -> A*", v.upcast, p.upcast, m.upcast);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "crosscast B* -> C*", v.crosscast, p.crosscast, m.crosscast);
+    printf("%-28s %10.2f %12.2f %10.2f\n", "downcast A* -> D*", v.downcast, p.downcast, m.downcast);
+    printf("(virtual casts across/down use dynamic_cast; the others are static_cast)   checksum %ld\n",
+           (v.checksum + p.checksum + m.checksum) % 1000);
+
+    return 0;
+}
@@ -85,9 +85,52 @@ public:
     D() { std::cout << "D's constructor\n"; }
 };
 
+// Mixin Alternative (CRTP)
+
+// When B and C are written together with D, the same single A can be had without virtual inheritance: D inherits A
+// normally, and B and C become policy templates that reach A through the derived class. static_cast<Derived&>(*this)
+// is resolved at compile time, so there is no virtual base offset to look up at run time (see diamond_benchmark.cpp).
+
+template <typename Derived>
+class BPolicy {
+public:
+    BPolicy() { std::cout << "B's constructor\n"; }
+    void displayFromB() {
+        std::cout << "B -> ";
+        derived().display();  // D's only A, found at compile time
+    }
+
+protected:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+template <typename Derived>
+class CPolicy {
+public:
+    CPolicy() { std::cout << "C's constructor\n"; }
+    void displayFromC() {
+        std::cout << "C -> ";
+        derived().display();  // D's only A, found at compile time
+    }
+
+protected:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+// Bases are constructed in declaration order: A, B, C, then D, exactly like the virtual diamond
+class MixinD : public A, public BPolicy<MixinD>, public CPolicy<MixinD> {
+public:
+    MixinD() { std::cout << "D's constructor\n"; }
+};
+
 int main() {
     D d;         // Create an instance of D
     d.display(); // Call the display method of A
 
+    MixinD m;    // Same output from the mixin layout
+    m.display();
+    m.displayFromB();  // B and C both reach the one A through D
+    m.displayFromC();
+
     return 0;
 }
@@ -0,0 +1,531 @@
+/*
+
+---------- ENTITY COMPONENT SYSTEM (ECS) ----------
+
+In hierarchical_inheritance.cpp and multilevel_inheritance.cpp behavior comes from the class an animal is: a Dog can
+eat() and sleep() because it is an Animal, breathe() because it is a Mammal, and bark() because it is a Dog.
+Simulating millions of animals that way means a vector of pointers to objects of different classes, scattered over
+the heap, with a virtual update() call per animal: every step is a cache miss followed by an indirect jump.
+
+An ECS turns this inside out:
+
+1. Entities: An animal is just an id.
+2. Components: Plain data structs (Position, Energy, Lungs, Barker, Meower, Flyer). An entity "is a Dog" because it
+   has the components a dog has, not because of its class.
+3. Archetypes: All entities with exactly the same set of components are stored together in one table, one dense array
+   (column) per component. Dogs are one archetype, Cats another, Birds a third.
+4. Systems: Functions over components. The breathe system asks for (Lungs, Energy) and is run over every archetype
+   that has both (Dogs and Cats), walking the columns linearly. Different rows are independent, so the rows are split
+   across threads.
+
+---------- HOW IT WORKS ----------
+
+World::create(components...): Finds (or creates) the archetype for that component set and appends one row.
+World::destroy(entity): Moves the last row of the archetype into the hole (swap-remove) and updates that entity's record.
+World::add / remove: Moves the entity's row to the archetype with one component more or less.
+World::each<Cs...>(f): Calls f(Cs&...) for every entity having all of Cs; eachParallel does the same on all threads.
+Entity Handles: An Entity is (index, generation); destroying an entity bumps the generation, so stale handles are
+                detected instead of pointing at a recycled entity.
+
+---------- RULES AND GUIDELINES ----------
+
+Components Are Plain Data: They must be trivially copyable (rows are moved with memcpy) and hold no behavior.
+Do Not Change Archetypes Inside each(): add, remove, create and destroy move rows; collect the changes and apply them
+                                        after the loop.
+Systems Must Not Share Rows: eachParallel gives every thread its own rows; writing to other entities is a data race.
+Compile: g++ -std=c++17 -O2 -pthread ecs_animals.cpp
+Run: ./a.out [animals, default 10000000] [ticks, default 10]   (each at least 1)
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ---------- COMPONENT TYPES ----------
+
+using ComponentMask = uint64_t;  // one bit per component type, at most 64 types
+
+// Size of each registered component type, indexed by component id
+inline vector<size_t>& componentSizes() {
+    static vector<size_t> sizes;
+    return sizes;
+}
+
+// A small id per component type, assigned on first use
+template <typename T>
+size_t componentId() {
+    static_assert(is_trivially_copyable<T>::value, "components are moved with memcpy");
+    static const size_t id = [] {
+        componentSizes().push_back(sizeof(T));
+        return componentSizes().size() - 1;
+    }();
+    return id;
+}
+
+template <typename... Cs>
+ComponentMask maskOf() {
+    return ((ComponentMask(1) << componentId<Cs>()) | ... | ComponentMask(0));
+}
+
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+};
+
+// ---------- ARCHETYPE ----------
+
+// All entities with the same component set, one byte column per component
+class Archetype {
+private:
+    ComponentMask mask;
+    vector<Entity> entities;
+    vector<vector<unsigned char>> columns;  // indexed by component id; empty for components not in the mask
+
+public:
+    explicit Archetype(ComponentMask m) : mask(m), columns(componentSizes().size()) {}
+
+    ComponentMask getMask() const { return mask; }
+    size_t size() const { return entities.size(); }
+    Entity entityAt(size_t row) const { return entities[row]; }
+
+    template <typename T>
+    T* column() {
+        return reinterpret_cast<T*>(columns[componentId<T>()].data());
+    }
+
+    unsigned char* cell(size_t id, size_t row) { return columns[id].data() + row * componentSizes()[id]; }
+
+    // Appends an uninitialized row; the caller fills every column
+    size_t appendRow(Entity e) {
+        entities.push_back(e);
+        for (size_t id = 0; id < columns.size(); ++id) {
+            if (mask >> id & 1) {
+                columns[id].resize(columns[id].size() + componentSizes()[id]);
+            }
+        }
+        return entities.size() - 1;
+    }
+
+    // Removes a row by moving the last row into it; returns the entity that moved (if any)
+    bool swapRemove(size_t row, Entity& moved) {
+        size_t last = entities.size() - 1;
+        bool movedOne = row != last;
+        for (size_t id = 0; id < columns.size(); ++id) {
+            if (mask >> id & 1) {
+                size_t bytes = componentSizes()[id];
+                if (movedOne) {
+                    memcpy(cell(id, row), cell(id, last), bytes);
+                }
+                columns[id].resize(columns[id].size() - bytes);
+            }
+        }
+        if (movedOne) {
+            entities[row] = entities[last];
+            moved = entities[row];
+        }
+        entities.pop_back();
+        return movedOne;
+    }
+
+    void reserve(size_t rows) {
+        entities.reserve(rows);
+        for (size_t id = 0; id < columns.size(); ++id) {
+            if (mask >> id & 1) {
+                columns[id].reserve(rows * componentSizes()[id]);
+            }
+        }
+    }
+};
+
+// ---------- WORLD ----------
+
+class World {
+private:
+    struct Record {
+        uint32_t archetype;
+        uint32_t row;
+        uint32_t generation;
+        bool alive;
+    };
+
+    vector<unique_ptr<Archetype>> archetypes;
+    unordered_map<ComponentMask, uint32_t> archetypeByMask;
+    vector<Record> records;
+    vector<uint32_t> freeIndices;
+
+    uint32_t archetypeFor(ComponentMask mask) {
+        auto found = archetypeByMask.find(mask);
+        if (found != archetypeByMask.end()) {
+            return found->second;
+        }
+        archetypes.push_back(make_unique<Archetype>(mask));
+        uint32_t index = static_cast<uint32_t>(archetypes.size() - 1);
+        archetypeByMask.emplace(mask, index);
+        return index;
+    }
+
+    Entity newEntity() {
+        if (!freeIndices.empty()) {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return {index, records[index].generation};
+        }
+        records.push_back({0, 0, 0, false});
+        return {static_cast<uint32_t>(records.size() - 1), 0};
+    }
+
+    void removeRow(uint32_t archetype, uint32_t row) {
+        Entity moved;
+        if (archetypes[archetype]->swapRemove(row, moved)) {
+            records[moved.index].row = row;
+        }
+    }
+
+    // Moves e to the archetype for newMask, copying the components both archetypes have
+    void moveTo(Entity e, ComponentMask newMask) {
+        Record& r = records[e.index];
+        uint32_t target = archetypeFor(newMask);
+        Archetype& from = *archetypes[r.archetype];
+        Archetype& to = *archetypes[target];
+        size_t row = to.appendRow(e);
+        ComponentMask shared = from.getMask() & newMask;
+        for (size_t id = 0; id < componentSizes().size(); ++id) {
+            if (shared >> id & 1) {
+                memcpy(to.cell(id, row), from.cell(id, r.row), componentSizes()[id]);
+            }
+        }
+        removeRow(r.archetype, r.row);
+        r.archetype = target;
+        r.row = static_cast<uint32_t>(row);
+    }
+
+public:
+    bool isAlive(Entity e) const {
+        return e.index < records.size() && records[e.index].alive && records[e.index].generation == e.generation;
+    }
+
+    template <typename... Cs>
+    Entity create(const Cs&... components) {
+        Entity e = newEntity();
+        uint32_t a = archetypeFor(maskOf<Cs...>());
+        size_t row = archetypes[a]->appendRow(e);
+        (memcpy(archetypes[a]->cell(componentId<Cs>(), row), &components, sizeof(Cs)), ...);
+        records[e.index] = {a, static_cast<uint32_t>(row), e.generation, true};
+        return e;
+    }
+
+    void destroy(Entity e) {
+        if (!isAlive(e)) {
+            return;
+        }
+        Record& r = records[e.index];
+        removeRow(r.archetype, r.row);
+        r.alive = false;
+        ++r.generation;
+        freeIndices.push_back(e.index);
+    }
+
+    template <typename T>
+    T* get(Entity e) {
+        if (!isAlive(e)) {
+            return nullptr;
+        }
+        Record& r = records[e.index];
+        Archetype& a = *archetypes[r.archetype];
+        return (a.getMask() >> componentId<T>() & 1) ? &a.column<T>()[r.row] : nullptr;
+    }
+
+    template <typename T>
+    void add(Entity e, const T& component) {
+        if (!isAlive(e) || get<T>(e)) {
+            return;
+        }
+        moveTo(e, archetypes[records[e.index].archetype]->getMask() | maskOf<T>());
+        *get<T>(e) = component;
+    }
+
+    template <typename T>
+    void remove(Entity e) {
+        if (isAlive(e) && get<T>(e)) {
+            moveTo(e, archetypes[records[e.index].archetype]->getMask() & ~maskOf<T>());
+        }
+    }
+
+    // Pre-sizes the archetype of Cs for `rows` entities
+    template <typename... Cs>
+    void reserve(size_t rows) {
+        archetypes[archetypeFor(maskOf<Cs...>())]->reserve(rows);
+    }
+
+    template <typename... Cs, typename F>
+    void each(F&& f) {
+        ComponentMask required = maskOf<Cs...>();
+        for (auto& a : archetypes) {
+            if ((a->getMask() & required) == required) {
+                auto columns = make_tuple(a->template column<Cs>()...);
+                for (size_t row = 0, n = a->size(); row < n; ++row) {
+                    f(std::get<Cs*>(columns)[row]...);
+                }
+            }
+        }
+    }
+
+    // Like each(), with the rows of all matching archetypes split into chunks handed out to all threads
+    template <typename... Cs, typename F>
+    void eachParallel(F&& f, unsigned threads = thread::hardware_concurrency()) {
+        constexpr size_t CHUNK = 16384;
+        struct Chunk {
+            Archetype* archetype;
+            size_t begin, end;
+        };
+        ComponentMask required = maskOf<Cs...>();
+        vector<Chunk> chunks;
+        for (auto& a : archetypes) {
+            if ((a->getMask() & required) == required) {
+                for (size_t b = 0; b < a->size(); b += CHUNK) {
+                    chunks.push_back({a.get(), b, min(a->size(), b + CHUNK)});
+                }
+            }
+        }
+        atomic<size_t> next{0};
+        auto work = [&] {
+            for (size_t c; (c = next.fetch_add(1, memory_order_relaxed)) < chunks.size();) {
+                auto columns = make_tuple(chunks[c].archetype->template column<Cs>()...);
+                for (size_t row = chunks[c].begin; row < chunks[c].end; ++row) {
+                    f(std::get<Cs*>(columns)[row]...);
+                }
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < max(1u, threads); ++t) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (thread& w : workers) {
+            w.join();
+        }
+    }
+};
+
+// ---------- ANIMAL COMPONENTS AND SYSTEMS ----------
+
+struct Position {
+    float x, y;
+};
+struct Energy {
+    float value;
+};
+struct Lungs {  // mammals breathe()
+    uint32_t breaths;
+};
+struct Barker {  // dogs bark()
+    uint32_t barks;
+};
+struct Meower {  // cats meow()
+    uint32_t meows;
+};
+struct Flyer {  // birds fly()
+    float altitude;
+};
+
+// One step of each behavior; shared by the ECS systems and the class hierarchy so both compute the same thing
+inline void eatOrSleep(Energy& e) {
+    e.value -= 0.01f;
+    e.value += e.value < 0.2f ? 0.05f : 0.015f;  // sleep() when tired, otherwise eat()
+}
+inline void breathe(Lungs& l, Energy& e) {
+    ++l.breaths;
+    e.value -= 0.001f;
+}
+inline void bark(Barker& b, const Position& p) { b.barks += p.x > 0.0f; }
+inline void meow(Meower& m) { ++m.meows; }
+inline void fly(Flyer& f, Position& p) {
+    f.altitude = f.altitude > 100.0f ? 0.0f : f.altitude + 0.5f;
+    p.x += 0.1f;
+}
+
+void tickEcs(World& world) {
+    world.eachParallel<Energy>([](Energy& e) { eatOrSleep(e); });
+    world.eachParallel<Lungs, Energy>([](Lungs& l, Energy& e) { breathe(l, e); });
+    world.eachParallel<Barker, Position>([](Barker& b, Position& p) { bark(b, p); });
+    world.eachParallel<Meower>([](Meower& m) { meow(m); });
+    world.eachParallel<Flyer, Position>([](Flyer& f, Position& p) { fly(f, p); });
+}
+
+// ---------- THE SAME ANIMALS AS A CLASS HIERARCHY ----------
+
+class Animal {
+public:
+    Position position;
+    Energy energy;
+
+    Animal(Position p, Energy e) : position(p), energy(e) {}
+    virtual ~Animal() = default;
+    virtual void update() { eatOrSleep(energy); }
+};
+
+class Mammal : public Animal {
+public:
+    Lungs lungs{0};
+
+    using Animal::Animal;
+    void update() override {
+        Animal::update();
+        breathe(lungs, energy);
+    }
+};
+
+class Dog : public Mammal {
+public:
+    Barker barker{0};
+
+    using Mammal::Mammal;
+    void update() override {
+        Mammal::update();
+        bark(barker, position);
+    }
+};
+
+class Cat : public Mammal {
+public:
+    Meower meower{0};
+
+    using Mammal::Mammal;
+    void update() override {
+        Mammal::update();
+        meow(meower);
+    }
+};
+
+class Bird : public Animal {
+public:
+    Flyer flyer{0.0f};
+
+    using Animal::Animal;
+    void update() override {
+        Animal::update();
+        fly(flyer, position);
+    }
+};
+
+// ---------- BENCHMARK ----------
+
+struct Totals {
+    double energy = 0, x = 0;
+    uint64_t breaths = 0, barks = 0, meows = 0;
+};
+
+// argv[index] as an integer clamped to [lo, hi], or fallback when it is absent
+static long long argument(int argc, char* argv[], int index, long long fallback, long long lo, long long hi) {
+    long long value = argc > index ? strtoll(argv[index], nullptr, 10) : fallback;
+    return min(max(value, lo), hi);
+}
+
+int main(int argc, char* argv[]) {
+    // Entities, components and archetype moves
+    World demo;
+    Entity rex = demo.create(Position{1, 2}, Energy{1.0f}, Lungs{0}, Barker{0});
+    Entity tweety = demo.create(Position{0, 0}, Energy{1.0f}, Flyer{0.0f});
+    tickEcs(demo);
+    cout << "Rex barked " << demo.get<Barker>(rex)->barks << " time(s), Tweety is at altitude "
+         << demo.get<Flyer>(tweety)->altitude << endl;
+    demo.add(tweety, Meower{0});  // Tweety learns to meow: moves to a new archetype
+    demo.remove<Barker>(rex);     // Rex stops barking
+    tickEcs(demo);
+    cout << "Tweety meowed " << demo.get<Meower>(tweety)->meows << " time(s), Rex "
+         << (demo.get<Barker>(rex) ? "still barks" : "no longer barks") << endl;
+    demo.destroy(rex);
+    cout << "Rex alive after destroy: " << (demo.isAlive(rex) ? "yes" : "no") << endl;
+
+    const size_t n = static_cast<size_t>(argument(argc, argv, 1, 10000000, 1, LLONG_MAX));
+    const int ticks = static_cast<int>(argument(argc, argv, 2, 10, 1, INT_MAX));
+
+    // The same random population in both representations: 40% dogs, 30% cats, 30% birds
+    World world;
+    vector<unique_ptr<Animal>> zoo;
+    zoo.reserve(n);
+    world.reserve<Position, Energy, Lungs, Barker>(n * 2 / 5);
+    world.reserve<Position, Energy, Lungs, Meower>(n * 3 / 10);
+    world.reserve<Position, Energy, Flyer>(n * 3 / 10);
+    mt19937 rng(1);
+    uniform_real_distribution<float> coordinate(-100.0f, 100.0f), energy(0.0f, 1.0f);
+    for (size_t i = 0; i < n; ++i) {
+        Position p{coordinate(rng), coordinate(rng)};
+        Energy e{energy(rng)};
+        unsigned kind = rng() % 10;
+        if (kind < 4) {
+            world.create(p, e, Lungs{0}, Barker{0});
+            zoo.push_back(make_unique<Dog>(p, e));
+        } else if (kind < 7) {
+            world.create(p, e, Lungs{0}, Meower{0});
+            zoo.push_back(make_unique<Cat>(p, e));
+        } else {
+            world.create(p, e, Flyer{0.0f});
+            zoo.push_back(make_unique<Bird>(p, e));
+        }
+    }
+
+    auto seconds = [](auto&& f) {
+        auto start = chrono::steady_clock::now();
+        f();
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    double tObjects = seconds([&] {
+        for (int t = 0; t < ticks; ++t) {
+            for (auto& animal : zoo) {
+                animal->update();
+            }
+        }
+    });
+    double tEcs = seconds([&] {
+        for (int t = 0; t < ticks; ++t) {
+            tickEcs(world);
+        }
+    });
+
+    // Both must end in the same state
+    Totals a, b;
+    for (auto& animal : zoo) {
+        a.energy += animal->energy.value;
+        a.x += animal->position.x;
+        if (auto* m = dynamic_cast<Mammal*>(animal.get())) a.breaths += m->lungs.breaths;
+        if (auto* d = dynamic_cast<Dog*>(animal.get())) a.barks += d->barker.barks;
+        if (auto* c = dynamic_cast<Cat*>(animal.get())) a.meows += c->meower.meows;
+    }
+    world.each<Energy, Position>([&](Energy& e, Position& p) {
+        b.energy += e.value;
+        b.x += p.x;
+    });
+    world.each<Lungs>([&](Lungs& l) { b.breaths += l.breaths; });
+    world.each<Barker>([&](Barker& d) { b.barks += d.barks; });
+    world.each<Meower>([&](Meower& m) { b.meows += m.meows; });
+    bool same = a.breaths == b.breaths && a.barks == b.barks && a.meows == b.meows &&
+                fabs(a.energy - b.energy) <= 1e-9 * fabs(a.energy) + 1e-6 && fabs(a.x - b.x) <= 1e-9 * fabs(a.x) + 1e-3;
+
+    double perTick = double(n) * ticks;
+    printf("\n%zu animals, %d ticks, %u threads\n", n, ticks, max(1u, thread::hardware_concurrency()));
+    printf("  class hierarchy (virtual update)  %7.1f ms/tick  %6.2f ns/animal\n", tObjects * 1e3 / ticks,
+           tObjects * 1e9 / perTick);
+    printf("  ECS (archetype columns)           %7.1f ms/tick  %6.2f ns/animal\n", tEcs * 1e3 / ticks,
+           tEcs * 1e9 / perTick);
+    printf("  final state %s\n", same ? "matches" : "MISMATCH");
+
+    return same ? 0 : 1;
+}
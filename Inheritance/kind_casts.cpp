@@ -0,0 +1,376 @@
+/*
+
+---------- CHECKED DOWNCASTS WITH KIND TAGS (isa / cast / dyn_cast) ----------
+
+Going from an Animal* back to the Dog* it really points at is a downcast. dynamic_cast does it safely, but it has to
+find out at run time whether the object is a Dog or derives from Dog: it walks the type_info of the object's class
+and of all its bases, and when the classes live in different shared libraries it may compare the mangled type names
+as strings. In a loop over millions of animals that is far more work than the loop body.
+
+LLVM (the compiler framework behind Clang) replaces dynamic_cast with a small facility of its own:
+
+1. Kind Tag: The base class stores a small enum value, set once by each constructor, that names the exact class.
+2. classof: Every class has a static classof(const Animal*) that answers "is this object one of mine?" by looking at
+   the tag only.
+3. Ranges: Kinds are numbered in depth-first order of the hierarchy, so a class and all classes below it get a
+   contiguous range: Mammal covers [Mammal, LastMammal], which includes Dog and Cat. "Is it a Mammal?" is then two
+   integer comparisons however deep or wide the hierarchy is.
+4. isa<T>(p), cast<T>(p), dyn_cast<T>(p): Generic functions that call T::classof and then static_cast.
+
+                Animal
+               /      \
+           Mammal     Bird
+           /    \
+         Dog    Cat
+
+   Kinds in depth-first order: Mammal, Dog, Cat (= LastMammal), Bird.
+
+The AbstractAnimal interface from abstraction.cpp gets the same treatment below. Its Dog and Cat are leaves directly
+under the interface, so each classof is a single comparison and code holding an AbstractAnimal* can reach getBreed()
+or getColor() without RTTI. The tag sits next to the vtable pointer and does not change the pure virtual interface.
+
+---------- HOW IT WORKS ----------
+
+isa<T>(p): True when p points at a T (or a class derived from T).
+cast<T>(p): Converts, asserting (in debug builds) that isa<T>(p). Use when the type is known.
+dyn_cast<T>(p): Converts if isa<T>(p), otherwise returns nullptr. The replacement for dynamic_cast<T*>(p).
+dyn_cast_if_present<T>(p): Like dyn_cast, but also accepts a null p.
+
+---------- RULES AND GUIDELINES ----------
+
+Keep The Kind Enum In Tree Order: Every class must be followed by all of its descendants, then a LastXxx marker, so
+                                  that the range check stays correct when classes are added.
+Set The Kind In The Constructor: Each constructor passes its own kind to its base; the tag never changes afterwards.
+No Cross Casts: Tags describe a single-inheritance tree; use dynamic_cast for multiple inheritance.
+No RTTI Needed: The facility works with -fno-rtti (dynamic_cast is only used here for the comparison).
+Compile: g++ -std=c++17 -O2 kind_casts.cpp
+
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------- isa / cast / dyn_cast ----------
+
+template <typename To, typename From>
+bool isa(const From* p) {
+    return To::classof(p);
+}
+
+template <typename To, typename From>
+To* cast(From* p) {
+    assert(p && isa<To>(p) && "cast<To>() argument of incompatible type");
+    return static_cast<To*>(p);
+}
+
+template <typename To, typename From>
+const To* cast(const From* p) {
+    assert(p && isa<To>(p) && "cast<To>() argument of incompatible type");
+    return static_cast<const To*>(p);
+}
+
+template <typename To, typename From>
+To* dyn_cast(From* p) {
+    return isa<To>(p) ? static_cast<To*>(p) : nullptr;
+}
+
+template <typename To, typename From>
+const To* dyn_cast(const From* p) {
+    return isa<To>(p) ? static_cast<const To*>(p) : nullptr;
+}
+
+template <typename To, typename From>
+To* dyn_cast_if_present(From* p) {
+    return p ? dyn_cast<To>(p) : nullptr;
+}
+
+// ---------- ANIMALS (hierarchical_inheritance.cpp and multilevel_inheritance.cpp) ----------
+
+class Animal {
+public:
+    // Depth-first order; every class is followed by its descendants and a Last marker
+    enum class Kind : uint8_t {
+        Mammal,
+        Dog,
+        Cat,
+        LastMammal = Cat,
+        Bird,
+    };
+
+    Kind getKind() const { return kind; }
+
+    void eat() const { cout << "Animal is eating." << endl; }
+    void sleep() const { cout << "Animal is sleeping." << endl; }
+
+    virtual ~Animal() = default;  // only so dynamic_cast can be compared below
+
+    static bool classof(const Animal*) { return true; }
+
+protected:
+    explicit Animal(Kind k) : kind(k) {}
+
+private:
+    const Kind kind;
+};
+
+class Mammal : public Animal {
+public:
+    void breathe() const { cout << "Mammal is breathing." << endl; }
+
+    static bool classof(const Animal* a) { return a->getKind() >= Kind::Mammal && a->getKind() <= Kind::LastMammal; }
+
+protected:
+    explicit Mammal(Kind k) : Animal(k) {}
+};
+
+class Dog : public Mammal {
+public:
+    Dog() : Mammal(Kind::Dog) {}
+
+    void bark() const { cout << "Dog is barking." << endl; }
+    int tricks = 3;
+
+    static bool classof(const Animal* a) { return a->getKind() == Kind::Dog; }
+};
+
+class Cat : public Mammal {
+public:
+    Cat() : Mammal(Kind::Cat) {}
+
+    void meow() const { cout << "Cat is meowing." << endl; }
+    int lives = 9;
+
+    static bool classof(const Animal* a) { return a->getKind() == Kind::Cat; }
+};
+
+class Bird : public Animal {
+public:
+    Bird() : Animal(Kind::Bird) {}
+
+    void fly() const { cout << "Bird is flying." << endl; }
+    int wingspan = 30;
+
+    static bool classof(const Animal* a) { return a->getKind() == Kind::Bird; }
+};
+
+// ---------- ABSTRACT ANIMALS (abstraction.cpp) ----------
+
+namespace abstraction {
+
+class AbstractAnimal {
+public:
+    enum class Kind : uint8_t {
+        Dog,
+        Cat,
+    };
+
+    Kind getKind() const { return kind; }
+
+    virtual void makeSound() const = 0;  // Pure virtual function
+    virtual ~AbstractAnimal() = default;
+
+    static bool classof(const AbstractAnimal*) { return true; }
+
+protected:
+    explicit AbstractAnimal(Kind k) : kind(k) {}
+
+private:
+    const Kind kind;
+};
+
+class Dog : public AbstractAnimal {
+private:
+    string breed;
+
+public:
+    explicit Dog(string b) : AbstractAnimal(Kind::Dog), breed(std::move(b)) {}
+    void makeSound() const override { cout << "Woof! Woof!" << endl; }
+    string getBreed() const { return breed; }
+
+    static bool classof(const AbstractAnimal* a) { return a->getKind() == Kind::Dog; }
+};
+
+class Cat : public AbstractAnimal {
+private:
+    string color;
+
+public:
+    explicit Cat(string c) : AbstractAnimal(Kind::Cat), color(std::move(c)) {}
+    void makeSound() const override { cout << "Meow! Meow!" << endl; }
+    string getColor() const { return color; }
+
+    static bool classof(const AbstractAnimal* a) { return a->getKind() == Kind::Cat; }
+};
+
+}  // namespace abstraction
+
+// ---------- SYNTHETIC DEEP AND WIDE HIERARCHIES FOR THE BENCHMARK ----------
+
+// Deep: Deep<0> <- Deep<1> <- ... <- Deep<DEPTH>, a single chain; kind = depth, Deep<N> covers kinds >= N
+constexpr int DEPTH = 12;
+
+struct DeepBase {
+    const uint8_t kind;
+    int payload = 1;
+    explicit DeepBase(uint8_t k) : kind(k) {}
+    virtual ~DeepBase() = default;
+    static bool classof(const DeepBase*) { return true; }
+};
+
+template <int N>
+struct Deep : Deep<N - 1> {
+    Deep() : Deep<N - 1>(N) {}
+    static bool classof(const DeepBase* b) { return b->kind >= N; }
+
+protected:
+    explicit Deep(uint8_t k) : Deep<N - 1>(k) {}
+};
+
+template <>
+struct Deep<0> : DeepBase {
+    Deep() : DeepBase(0) {}
+    static bool classof(const DeepBase*) { return true; }
+
+protected:
+    explicit Deep(uint8_t k) : DeepBase(k) {}
+};
+
+// Wide: WIDTH sibling classes directly below one base; Wide<I> covers kind I only
+constexpr int WIDTH = 32;
+
+struct WideBase {
+    const uint8_t kind;
+    int payload = 1;
+    explicit WideBase(uint8_t k) : kind(k) {}
+    virtual ~WideBase() = default;
+};
+
+template <int I>
+struct Wide : WideBase {
+    Wide() : WideBase(I) {}
+    static bool classof(const WideBase* b) { return b->kind == I; }
+};
+
+// ---------- BENCHMARK ----------
+
+template <typename T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+template <typename F>
+double nsPerItem(size_t n, int repeats, F&& f) {
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        f();
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (double(n) * repeats);
+}
+
+// Counts objects that convert to Target and sums a member, with dyn_cast and with dynamic_cast
+template <typename Target, typename Base>
+void compare(const char* label, const vector<unique_ptr<Base>>& objects) {
+    const size_t n = objects.size();
+    long viaKind = 0, viaRtti = 0;
+    double tKind = nsPerItem(n, 10, [&] {
+        long sum = 0;
+        for (const auto& p : objects) {
+            if (const Target* t = dyn_cast<Target>(p.get())) sum += t->payload;
+        }
+        viaKind = sum;
+        keep(viaKind);
+    });
+    double tRtti = nsPerItem(n, 10, [&] {
+        long sum = 0;
+        for (const auto& p : objects) {
+            if (const Target* t = dynamic_cast<const Target*>(p.get())) sum += t->payload;
+        }
+        viaRtti = sum;
+        keep(viaRtti);
+    });
+    printf("  %-34s dyn_cast %6.2f ns   dynamic_cast %6.2f ns   %s\n", label, tKind, tRtti,
+           viaKind == viaRtti ? "" : "MISMATCH");
+}
+
+template <int... I>
+vector<unique_ptr<DeepBase>> makeDeep(size_t n, mt19937& rng, integer_sequence<int, I...>) {
+    using Factory = unique_ptr<DeepBase> (*)();
+    Factory factories[] = {[]() -> unique_ptr<DeepBase> { return make_unique<Deep<I>>(); }...};
+    vector<unique_ptr<DeepBase>> objects;
+    for (size_t i = 0; i < n; ++i) {
+        objects.push_back(factories[rng() % sizeof...(I)]());
+    }
+    return objects;
+}
+
+template <int... I>
+vector<unique_ptr<WideBase>> makeWide(size_t n, mt19937& rng, integer_sequence<int, I...>) {
+    using Factory = unique_ptr<WideBase> (*)();
+    Factory factories[] = {[]() -> unique_ptr<WideBase> { return make_unique<Wide<I>>(); }...};
+    vector<unique_ptr<WideBase>> objects;
+    for (size_t i = 0; i < n; ++i) {
+        objects.push_back(factories[rng() % sizeof...(I)]());
+    }
+    return objects;
+}
+
+int main() {
+    vector<unique_ptr<Animal>> zoo;
+    zoo.push_back(make_unique<Dog>());
+    zoo.push_back(make_unique<Cat>());
+    zoo.push_back(make_unique<Bird>());
+
+    for (const auto& animal : zoo) {
+        animal->eat();
+        if (const Mammal* m = dyn_cast<Mammal>(animal.get())) {
+            m->breathe();
+        }
+        if (const Dog* d = dyn_cast<Dog>(animal.get())) {
+            d->bark();
+        } else if (isa<Cat>(animal.get())) {
+            cast<Cat>(animal.get())->meow();
+        } else if (const Bird* b = dyn_cast<Bird>(animal.get())) {
+            b->fly();
+        }
+    }
+    Animal* nobody = nullptr;
+    cout << "dyn_cast_if_present on nullptr: " << (dyn_cast_if_present<Dog>(nobody) ? "Dog" : "nullptr") << endl;
+
+    vector<unique_ptr<abstraction::AbstractAnimal>> pets;
+    pets.push_back(make_unique<abstraction::Dog>("Labrador"));
+    pets.push_back(make_unique<abstraction::Cat>("White"));
+    for (const auto& pet : pets) {
+        pet->makeSound();
+        if (const auto* d = dyn_cast<abstraction::Dog>(pet.get())) {
+            cout << "  a " << d->getBreed() << endl;
+        } else if (const auto* c = dyn_cast<abstraction::Cat>(pet.get())) {
+            cout << "  a " << c->getColor() << " cat" << endl;
+        }
+    }
+
+    const size_t n = 1 << 16;  // fits in cache, so the cast rather than memory is measured
+    mt19937 rng(9);
+    auto deep = makeDeep(n, rng, make_integer_sequence<int, DEPTH + 1>());
+    auto wide = makeWide(n, rng, make_integer_sequence<int, WIDTH>());
+
+    printf("\nper object, %zu objects of random classes\n", n);
+    printf("deep chain of %d levels:\n", DEPTH + 1);
+    compare<Deep<1>>("to Deep<1> (almost always a hit)", deep);
+    compare<Deep<DEPTH / 2>>("to Deep<middle>", deep);
+    compare<Deep<DEPTH>>("to Deep<leaf> (rarely a hit)", deep);
+    printf("%d siblings below one base:\n", WIDTH);
+    compare<Wide<0>>("to Wide<0>", wide);
+    compare<Wide<WIDTH - 1>>("to Wide<last>", wide);
+
+    return 0;
+}
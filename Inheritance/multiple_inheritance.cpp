@@ -43,6 +43,8 @@ Destructor Order: The destructor of the derived class is called first, followed
 */
 
 #include <iostream>
+#include <string>
+#include <string_view>
 using namespace std;
 
 // Base class 1
@@ -60,6 +62,10 @@ public:
         cout << "Name: " << name << endl;
     }
 
+    string_view getName() const {
+        return name;
+    }
+
 private:
     string name;
 };
@@ -0,0 +1,408 @@
+/*
+
+---------- ORG HIERARCHY ----------
+
+Manager in multiple_inheritance.cpp has a name and an id but no reports, so it cannot describe an organization. The
+obvious fix, a vector<Manager*> of reports in every Manager, makes the questions analytics asks expensive: "how many
+people work under this VP?" or "what is the total salary of this department?" visit every node of the subtree
+through pointers, O(subtree size) random memory accesses per query.
+
+OrgChart stores the tree as a handful of flat arrays indexed by node number and answers those questions in O(1) or
+O(log n), independent of the size of the subtree.
+
+---------- HOW IT WORKS ----------
+
+Parent Array: parent[v] is the manager of v (-1 for the root). This is the input; everything else is derived from it.
+Children (CSR): The direct reports of v are children[childStart[v] .. childStart[v + 1]), one contiguous slice
+                ("compressed sparse row", the usual layout for graphs).
+Euler Tour Intervals: Numbering nodes in depth-first order gives every subtree a contiguous range of numbers:
+                      v's subtree is exactly the nodes with tin in [tin[v], tin[v] + size[v]). So
+                      - headcount(v) = size[v] - 1                                    O(1)
+                      - isUnder(a, b) = tin[b] <= tin[a] < tin[b] + size[b]          O(1)
+                      - subtreeTotal(v) = sum of values over that range              O(log n), Fenwick tree
+                      A Fenwick (binary indexed) tree over values in tour order also makes setValue() O(log n).
+Parallel Rebuild: After bulk moves the arrays are rebuilt level by level (breadth-first). All nodes on one level are
+                  independent, so steps 2-4 are parallel loops over one level at a time:
+                  1. Children CSR: count reports per manager, prefix-sum, fill (one linear counting sort).
+                  2. Levels: the next level is the concatenation of the children of the current one.
+                  3. Sizes bottom-up: size[v] = 1 + sum of the sizes of v's children.
+                  4. Tour numbers top-down: the first child starts right after v, each next child after the
+                     previous child's subtree.
+
+---------- RULES AND GUIDELINES ----------
+
+Moves Are Batched: moveSubtrees() takes many (node, new manager) changes and rebuilds once.
+Cycles Are Rejected: A move that would put a manager under their own report throws invalid_argument and leaves the
+                     chart unchanged.
+Nodes Must Exist: A move naming a node or manager outside the chart throws out_of_range before anything is changed.
+Compile: g++ -std=c++17 -O2 -pthread org_hierarchy.cpp
+Run: ./a.out [nodes, default 10000000]   (needs about 1 GB)
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Runs f(begin, end) over [0, count) split across threads; small ranges run on the calling thread
+template <typename F>
+void parallelFor(size_t count, unsigned threads, F&& f) {
+    if (threads <= 1 || count < 16384) {
+        f(size_t(0), count);
+        return;
+    }
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back([&, t] { f(count * t / threads, count * (t + 1) / threads); });
+    }
+    f(size_t(0), count / threads);
+    for (thread& w : workers) {
+        w.join();
+    }
+}
+
+class OrgChart {
+private:
+    size_t n = 0;
+    int32_t root = -1;
+    vector<int32_t> parent;
+    vector<double> value;  // per node, e.g. salary
+
+    vector<uint32_t> childStart;  // n + 1 entries
+    vector<uint32_t> children;
+    vector<uint32_t> bfs;         // nodes in breadth-first order
+    vector<uint32_t> levelStart;  // level d is bfs[levelStart[d] .. levelStart[d + 1])
+    vector<uint32_t> subtreeSize;
+    vector<uint32_t> tin;         // position in the depth-first tour
+    vector<double> fenwick;       // 1-based, over values in tour order
+
+    // Builds every derived array from newParent into fresh storage; commits only if the tree is valid
+    void rebuild(vector<int32_t> newParent, unsigned threads) {
+        const size_t count = newParent.size();
+        int32_t newRoot = -1;
+        for (size_t v = 0; v < count; ++v) {
+            int32_t p = newParent[v];
+            if (p < 0) {
+                if (newRoot >= 0) {
+                    throw invalid_argument("org chart has more than one root");
+                }
+                newRoot = static_cast<int32_t>(v);
+            } else if (static_cast<size_t>(p) >= count || static_cast<size_t>(p) == v) {
+                throw invalid_argument("invalid manager for node " + to_string(v));
+            }
+        }
+        if (count == 0) {
+            *this = OrgChart();
+            return;
+        }
+        if (newRoot < 0) {
+            throw invalid_argument("org chart has no root");
+        }
+
+        // 1. Children CSR (counting sort by parent; children stay in node order)
+        vector<uint32_t> start(count + 1, 0), kids(count - 1);
+        for (size_t v = 0; v < count; ++v) {
+            if (newParent[v] >= 0) {
+                ++start[static_cast<size_t>(newParent[v]) + 1];
+            }
+        }
+        partial_sum(start.begin(), start.end(), start.begin());
+        {
+            vector<uint32_t> cursor(start.begin(), start.end() - 1);
+            for (size_t v = 0; v < count; ++v) {
+                if (newParent[v] >= 0) {
+                    kids[cursor[static_cast<size_t>(newParent[v])]++] = static_cast<uint32_t>(v);
+                }
+            }
+        }
+
+        // 2. Levels
+        vector<uint32_t> order(count), levels = {0, 1};
+        order[0] = static_cast<uint32_t>(newRoot);
+        vector<uint32_t> offsets;
+        while (levels[levels.size() - 2] < levels.back()) {
+            size_t first = levels[levels.size() - 2], last = levels.back();
+            // Output position of each node's children on the next level
+            offsets.resize(last - first + 1);
+            offsets[0] = static_cast<uint32_t>(last);
+            for (size_t i = first; i < last; ++i) {
+                uint32_t v = order[i];
+                offsets[i - first + 1] = offsets[i - first] + (start[v + 1] - start[v]);
+            }
+            if (offsets.back() > count) {
+                throw invalid_argument("org chart contains a cycle");
+            }
+            parallelFor(last - first, threads, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) {
+                    uint32_t v = order[first + i];
+                    copy(kids.begin() + start[v], kids.begin() + start[v + 1], order.begin() + offsets[i]);
+                }
+            });
+            levels.push_back(offsets.back());
+        }
+        levels.pop_back();  // the last level added was empty
+        if (levels.back() != count) {
+            throw invalid_argument("org chart contains a cycle");  // some nodes are not reachable from the root
+        }
+
+        // 3. Subtree sizes, deepest level first
+        vector<uint32_t> sizes(count, 1);
+        for (size_t d = levels.size() - 1; d-- > 0;) {
+            parallelFor(levels[d + 1] - levels[d], threads, [&](size_t b, size_t e) {
+                for (size_t i = levels[d] + b; i < levels[d] + e; ++i) {
+                    uint32_t v = order[i];
+                    uint32_t s = 1;
+                    for (uint32_t k = start[v]; k < start[v + 1]; ++k) {
+                        s += sizes[kids[k]];
+                    }
+                    sizes[v] = s;
+                }
+            });
+        }
+
+        // 4. Tour positions, root level first
+        vector<uint32_t> enter(count, 0);
+        for (size_t d = 0; d + 1 < levels.size(); ++d) {
+            parallelFor(levels[d + 1] - levels[d], threads, [&](size_t b, size_t e) {
+                for (size_t i = levels[d] + b; i < levels[d] + e; ++i) {
+                    uint32_t v = order[i];
+                    uint32_t pos = enter[v] + 1;
+                    for (uint32_t k = start[v]; k < start[v + 1]; ++k) {
+                        enter[kids[k]] = pos;
+                        pos += sizes[kids[k]];
+                    }
+                }
+            });
+        }
+
+        // Fenwick tree over values in tour order, built in O(n)
+        vector<double> tree(count + 1, 0.0);
+        vector<double> values = value;
+        values.resize(count, 0.0);
+        parallelFor(count, threads, [&](size_t b, size_t e) {
+            for (size_t v = b; v < e; ++v) {
+                tree[enter[v] + 1] = values[v];
+            }
+        });
+        for (size_t i = 1; i <= count; ++i) {
+            size_t j = i + (i & (~i + 1));
+            if (j <= count) {
+                tree[j] += tree[i];
+            }
+        }
+
+        // Everything is valid: commit
+        n = count;
+        root = newRoot;
+        parent = std::move(newParent);
+        value = std::move(values);
+        childStart = std::move(start);
+        children = std::move(kids);
+        bfs = std::move(order);
+        levelStart = std::move(levels);
+        subtreeSize = std::move(sizes);
+        tin = std::move(enter);
+        fenwick = std::move(tree);
+    }
+
+    double prefixSum(size_t count) const {
+        double sum = 0.0;
+        for (size_t i = count; i > 0; i &= i - 1) {
+            sum += fenwick[i];
+        }
+        return sum;
+    }
+
+public:
+    OrgChart() = default;
+
+    // parents[v] is the manager of node v, -1 for the root; values[v] is the node's value (e.g. salary)
+    OrgChart(vector<int32_t> parents, vector<double> values, unsigned threads = thread::hardware_concurrency()) {
+        value = std::move(values);
+        rebuild(std::move(parents), max(1u, threads));
+    }
+
+    size_t size() const { return n; }
+    size_t depth() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+    int32_t getRoot() const { return root; }
+    int32_t getManager(uint32_t v) const { return parent[v]; }
+
+    // Everyone below v, at any level
+    uint32_t headcount(uint32_t v) const { return subtreeSize[v] - 1; }
+
+    // True when a reports to b, directly or indirectly (or a == b)
+    bool isUnder(uint32_t a, uint32_t b) const { return tin[b] <= tin[a] && tin[a] < tin[b] + subtreeSize[b]; }
+
+    // Sum of the values of v and everyone below v
+    double subtreeTotal(uint32_t v) const { return prefixSum(tin[v] + subtreeSize[v]) - prefixSum(tin[v]); }
+
+    void setValue(uint32_t v, double newValue) {
+        double delta = newValue - value[v];
+        value[v] = newValue;
+        for (size_t i = tin[v] + 1; i <= n; i += i & (~i + 1)) {
+            fenwick[i] += delta;
+        }
+    }
+
+    template <typename F>
+    void forEachDirectReport(uint32_t v, F&& f) const {
+        for (uint32_t k = childStart[v]; k < childStart[v + 1]; ++k) {
+            f(children[k]);
+        }
+    }
+
+    // Applies all (node, new manager) moves, then rebuilds once; throws and keeps the old chart on a bad node number
+    // or a cycle
+    void moveSubtrees(const vector<pair<uint32_t, int32_t>>& moves, unsigned threads = thread::hardware_concurrency()) {
+        vector<int32_t> newParent = parent;
+        for (const auto& [node, manager] : moves) {
+            if (node >= parent.size() || manager < -1 || (manager >= 0 && size_t(manager) >= parent.size())) {
+                throw out_of_range("move of node " + to_string(node) + " to manager " + to_string(manager) +
+                                   " outside a chart of " + to_string(parent.size()));
+            }
+            newParent[node] = manager;
+        }
+        rebuild(std::move(newParent), max(1u, threads));
+    }
+};
+
+// Manager from multiple_inheritance.cpp, now with a place in the org chart
+class Manager {
+public:
+    Manager(string name, int id, double salary) : name(std::move(name)), employeeID(id), salary(salary) {}
+
+    const string& getName() const { return name; }
+    int getID() const { return employeeID; }
+    double getSalary() const { return salary; }
+
+private:
+    string name;
+    int employeeID;
+    double salary;
+};
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Pointer-chasing baseline: visit the whole subtree through the children lists
+double naiveTotal(const OrgChart& chart, const vector<double>& values, uint32_t v) {
+    double sum = values[v];
+    chart.forEachDirectReport(v, [&](uint32_t c) { sum += naiveTotal(chart, values, c); });
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    // A small organization; node i is staff[i]
+    vector<Manager> staff = {{"CEO", 100, 500}, {"VP Eng", 101, 300}, {"VP Sales", 102, 280},
+                             {"Eng Lead", 103, 200}, {"Engineer", 104, 150}, {"Engineer", 105, 150},
+                             {"Account Exec", 106, 120}};
+    vector<int32_t> managers = {-1, 0, 0, 1, 3, 3, 2};
+    vector<double> salaries;
+    for (const Manager& m : staff) {
+        salaries.push_back(m.getSalary());
+    }
+    OrgChart org(managers, salaries);
+    for (uint32_t v : {0u, 1u, 3u}) {
+        cout << staff[v].getName() << ": " << org.headcount(v) << " people below, total salary " << org.subtreeTotal(v)
+             << endl;
+    }
+    org.moveSubtrees({{3, 2}});  // Eng Lead and their team move to Sales
+    cout << "After the move, VP Sales has " << org.headcount(2) << " people below, total salary "
+         << org.subtreeTotal(2) << endl;
+    try {
+        org.moveSubtrees({{2, 6}});  // VP Sales under their own Account Exec
+    } catch (const invalid_argument& e) {
+        cout << "Rejected move: " << e.what() << endl;
+    }
+    try {
+        org.moveSubtrees({{uint32_t(staff.size() + 5), 0}});  // nobody with that number
+    } catch (const out_of_range& e) {
+        cout << "Rejected move: " << e.what() << endl;
+    }
+
+    // Synthetic hierarchy: fan-out of about 8 per manager, node numbers shuffled so they are not in tree order
+    const size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    mt19937_64 rng(42);
+    vector<uint32_t> label(n);
+    iota(label.begin(), label.end(), 0u);
+    shuffle(label.begin() + 1, label.end(), rng);
+    vector<int32_t> parents(n);
+    vector<double> values(n);
+    parents[label[0]] = -1;
+    for (size_t i = 1; i < n; ++i) {
+        size_t lo = (i - 1) / 10, hi = (i - 1) / 6;
+        parents[label[i]] = static_cast<int32_t>(label[lo + rng() % (hi - lo + 1)]);
+    }
+    for (double& v : values) {
+        v = 50000 + double(rng() % 100000);
+    }
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    printf("\n%zu nodes\n", n);
+    OrgChart chart;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        double t = seconds([&] { chart = OrgChart(parents, values, threads); });
+        printf("  build, %2u threads            %8.1f ms\n", threads, t * 1e3);
+    }
+    printf("  depth %zu, root headcount %u\n", chart.depth(), chart.headcount(static_cast<uint32_t>(chart.getRoot())));
+
+    // Queries on random nodes
+    const size_t queries = 1000000;
+    vector<uint32_t> nodes(queries);
+    for (uint32_t& v : nodes) {
+        v = static_cast<uint32_t>(rng() % n);
+    }
+    uint64_t heads = 0;
+    double totals = 0;
+    double tHead = seconds([&] { for (uint32_t v : nodes) heads += chart.headcount(v); });
+    double tTotal = seconds([&] { for (uint32_t v : nodes) totals += chart.subtreeTotal(v); });
+
+    // The pointer-chasing walk, on the managers two levels below the root (large subtrees)
+    vector<uint32_t> big;
+    chart.forEachDirectReport(static_cast<uint32_t>(chart.getRoot()), [&](uint32_t c) {
+        chart.forEachDirectReport(c, [&](uint32_t g) { big.push_back(g); });
+    });
+    double naiveSum = 0, fastSum = 0;
+    double tNaive = seconds([&] { for (uint32_t v : big) naiveSum += naiveTotal(chart, values, v); });
+    double tFast = seconds([&] { for (uint32_t v : big) fastSum += chart.subtreeTotal(v); });
+
+    printf("  headcount                    %8.1f ns/query\n", tHead * 1e9 / double(queries));
+    printf("  subtreeTotal                 %8.1f ns/query\n", tTotal * 1e9 / double(queries));
+    printf("  %zu large subtrees (~%zu nodes each): walk %.1f ms, subtreeTotal %.4f ms, %s\n", big.size(),
+           big.empty() ? size_t(0) : size_t(chart.headcount(big[0])), tNaive * 1e3, tFast * 1e3,
+           abs(naiveSum - fastSum) <= 1e-9 * naiveSum ? "same totals" : "MISMATCH");
+
+    // Bulk move: 1% of the nodes get a new manager (one level up, which can never create a cycle)
+    vector<pair<uint32_t, int32_t>> moves;
+    for (size_t i = 0; i < n / 100; ++i) {
+        uint32_t v = static_cast<uint32_t>(rng() % n);
+        int32_t p = chart.getManager(v);
+        if (p >= 0 && chart.getManager(static_cast<uint32_t>(p)) >= 0) {
+            moves.emplace_back(v, chart.getManager(static_cast<uint32_t>(p)));
+        }
+    }
+    double tMove = seconds([&] { chart.moveSubtrees(moves, maxThreads); });
+    printf("  moveSubtrees (%zu moves)   %8.1f ms\n", moves.size(), tMove * 1e3);
+    printf("  (checksum %llu)\n", static_cast<unsigned long long>(heads + static_cast<uint64_t>(totals) % 1000));
+
+    return 0;
+}
@@ -42,6 +42,8 @@ Destructor Order: The destructor of the derived class is called first, followed
 */
 
 #include <iostream>
+#include <string>
+#include <string_view>
 using namespace std;
 
 // Base class
@@ -56,7 +58,7 @@ public:
         type = t;
     }
 
-    string getType() const {
+    string_view getType() const {
         return type;
     }
 
@@ -81,7 +83,7 @@ public:
         name = n;
     }
 
-    string getName() const {
+    string_view getName() const {
         return name;
     }
 
@@ -0,0 +1,510 @@
+/*
+
+---------- TASK GRAPH SCHEDULER ----------
+
+main() in hierarchical_inheritance.cpp calls myDog.eat(), myDog.bark(), myCat.meow() ... one after the other on the
+main thread. With millions of animals per frame the behaviors of different animals are independent and can run on
+all cores, but some steps still depend on others: an animal must eat or sleep before it breathes, and a dog barks at
+its neighbor only once the neighbor's energy for this frame is final.
+
+A task graph states exactly those dependencies and nothing more; a scheduler then runs every task as soon as all its
+predecessors have finished.
+
+---------- HOW IT WORKS ----------
+
+TaskGraph: Nodes are tasks (a name and a function), edges are "must finish before" (precede(a, b)). Built once and
+           run every frame.
+Batching: One task per animal would cost more in scheduling than the behavior itself, so each task handles a batch
+          of consecutive animals. Per frame and batch b the graph has:
+              needs[b] (eat or sleep) -> breathe[b] -> act[b] (bark, meow, fly) -> summary
+              breathe[b + 1] -> act[b]       (a dog barks when the next animal is hungry)
+          Nothing else is ordered, so act[3] may run while needs[900] has not even started.
+Work-Stealing Pool: Every worker owns a deque. A finished task pushes the successors it made ready onto the back of
+                    its own deque and the worker pops from the back again (the data is still in its cache). An idle
+                    worker steals from the front of another worker's deque, taking the oldest, usually largest,
+                    piece of work. Workers with nothing to do sleep on a condition variable. The thread calling run()
+                    acts as worker 0, so a pool of one thread runs everything on the caller.
+Deterministic Results: Tasks write only their own batch, randomness is a hash of (frame, animal), and the summary task
+                       adds the per-batch results in batch order. Any thread count therefore produces the same state
+                       bit for bit.
+Deterministic Replay: run() can record the order in which tasks started. replay() executes a recorded frame serially
+                      in that order (after checking that it respects the dependencies), so a frame that misbehaved on
+                      16 threads can be stepped through in a debugger on one.
+
+---------- RULES AND GUIDELINES ----------
+
+Declare Every Data Dependency: Two tasks that touch the same data must be ordered by an edge, or the result depends
+                               on timing. Here that is why act (which dogs use to read the next animal's energy)
+                               never writes energy itself.
+Size Batches For The Overhead: A task costs roughly a microsecond to schedule; aim for batches of tens of
+                               microseconds of work.
+No Waiting Inside Tasks: A task that blocks holds a worker; express the wait as an edge instead.
+Compile: g++ -std=c++17 -O2 -pthread task_graph_scheduler.cpp
+Run: ./a.out [animals, default 1000000] [frames, default 100] [max threads, default all cores]
+     (each argument is clamped to at least 1; max threads to at most 256)
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ---------- WORK-STEALING POOL ----------
+
+// A unit of work for the pool: a plain function pointer and its arguments, so queuing never allocates
+struct Job {
+    void (*run)(void* context, uint32_t arg);
+    void* context;
+    uint32_t arg;
+};
+
+class WorkStealingPool {
+private:
+    struct Queue {
+        mutex m;
+        deque<Job> jobs;
+    };
+
+    vector<unique_ptr<Queue>> queues;  // queues[0] belongs to the thread calling helpUntil()
+    vector<thread> threads;
+    atomic<size_t> queued{0};
+    atomic<int> sleepers{0};
+    atomic<bool> stopping{false};
+    mutex sleepMutex;
+    condition_variable wake;
+
+    static thread_local int self;  // this thread's queue index, -1 outside the pool
+
+    bool popOwn(int i, Job& job) {
+        Queue& q = *queues[i];
+        lock_guard<mutex> lock(q.m);
+        if (q.jobs.empty()) {
+            return false;
+        }
+        job = q.jobs.back();
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(int thief, Job& job) {
+        int n = static_cast<int>(queues.size());
+        for (int k = 1; k < n; ++k) {
+            Queue& q = *queues[(thief + k) % n];
+            lock_guard<mutex> lock(q.m);
+            if (!q.jobs.empty()) {
+                job = q.jobs.front();
+                q.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool runOne(int i) {
+        Job job;
+        if (!popOwn(i, job) && !steal(i, job)) {
+            return false;
+        }
+        queued.fetch_sub(1);
+        job.run(job.context, job.arg);
+        return true;
+    }
+
+    void workerLoop(int i) {
+        self = i;
+        while (!stopping.load()) {
+            if (runOne(i)) {
+                continue;
+            }
+            unique_lock<mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [&] { return queued.load() > 0 || stopping.load(); });
+            sleepers.fetch_sub(1);
+        }
+    }
+
+public:
+    explicit WorkStealingPool(unsigned threadCount) {
+        threadCount = max(1u, threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            queues.push_back(make_unique<Queue>());
+        }
+        for (unsigned i = 1; i < threadCount; ++i) {
+            threads.emplace_back([this, i] { workerLoop(static_cast<int>(i)); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping.store(true);
+        }
+        wake.notify_all();
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Queues a job on the calling worker's own deque (or on worker 0's from outside the pool)
+    void push(Job job) {
+        Queue& q = *queues[self >= 0 ? self : 0];
+        {
+            lock_guard<mutex> lock(q.m);
+            q.jobs.push_back(job);
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            lock_guard<mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    // Runs jobs on the calling thread, as worker 0, until done() returns true
+    template <typename Done>
+    void helpUntil(Done&& done) {
+        int previous = self;
+        self = 0;
+        while (!done()) {
+            if (!runOne(0)) {
+                this_thread::yield();
+            }
+        }
+        self = previous;
+    }
+};
+
+thread_local int WorkStealingPool::self = -1;
+
+// ---------- TASK GRAPH ----------
+
+class TaskGraph {
+private:
+    struct Node {
+        string name;
+        function<void()> work;
+        vector<uint32_t> successors;
+        uint32_t predecessors = 0;
+    };
+
+    vector<Node> nodes;
+
+    friend class Executor;
+
+public:
+    uint32_t add(string name, function<void()> work) {
+        nodes.push_back({move(name), move(work), {}, 0});
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    // `before` must finish before `after` starts
+    void precede(uint32_t before, uint32_t after) {
+        nodes[before].successors.push_back(after);
+        ++nodes[after].predecessors;
+    }
+
+    size_t size() const { return nodes.size(); }
+    const string& name(uint32_t task) const { return nodes[task].name; }
+};
+
+// The order in which the tasks of one run started
+using Trace = vector<uint32_t>;
+
+class Executor {
+private:
+    WorkStealingPool& pool;
+
+    struct Run {
+        const TaskGraph* graph;
+        WorkStealingPool* pool;
+        unique_ptr<atomic<uint32_t>[]> pending;
+        atomic<size_t> remaining;
+        Trace* trace;
+        atomic<size_t> traceCursor{0};
+    };
+
+    static void execute(void* context, uint32_t task) {
+        Run& run = *static_cast<Run*>(context);
+        if (run.trace) {
+            (*run.trace)[run.traceCursor.fetch_add(1)] = task;
+        }
+        const TaskGraph::Node& node = run.graph->nodes[task];
+        node.work();
+        for (uint32_t next : node.successors) {
+            if (run.pending[next].fetch_sub(1, memory_order_acq_rel) == 1) {
+                run.pool->push({execute, &run, next});
+            }
+        }
+        run.remaining.fetch_sub(1, memory_order_release);
+    }
+
+public:
+    explicit Executor(WorkStealingPool& p) : pool(p) {}
+
+    // Runs every task of the graph once, respecting the edges; optionally records the start order
+    void run(const TaskGraph& graph, Trace* trace = nullptr) {
+        const size_t n = graph.nodes.size();
+        Run run{&graph, &pool, make_unique<atomic<uint32_t>[]>(n), {n}, trace};
+        if (trace) {
+            trace->assign(n, 0);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            run.pending[i].store(graph.nodes[i].predecessors, memory_order_relaxed);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (graph.nodes[i].predecessors == 0) {
+                pool.push({execute, &run, static_cast<uint32_t>(i)});
+            }
+        }
+        pool.helpUntil([&] { return run.remaining.load(memory_order_acquire) == 0; });
+    }
+
+    // Runs a recorded frame again, serially and in the recorded order
+    static void replay(const TaskGraph& graph, const Trace& trace) {
+        const size_t n = graph.nodes.size();
+        if (trace.size() != n) {
+            throw invalid_argument("trace does not belong to this graph");
+        }
+        vector<uint32_t> pending(n);
+        for (size_t i = 0; i < n; ++i) {
+            pending[i] = graph.nodes[i].predecessors;
+        }
+        for (uint32_t task : trace) {
+            if (task >= n || pending[task] != 0) {
+                throw invalid_argument("trace runs a task before its predecessors");
+            }
+            pending[task] = UINT32_MAX;  // ran
+            graph.nodes[task].work();
+            for (uint32_t next : graph.nodes[task].successors) {
+                --pending[next];
+            }
+        }
+    }
+};
+
+// ---------- ANIMALS ----------
+
+enum class Species : uint8_t { Dog, Cat, Bird };
+
+struct AnimalState {
+    Species species;
+    float energy;
+    uint32_t breaths;
+    uint32_t sounds;  // barks or meows
+    float altitude;
+};
+
+// Per (frame, animal) randomness that does not depend on which thread runs the animal
+inline uint32_t noise(uint32_t frame, uint32_t animal) {
+    uint64_t x = (uint64_t(frame) << 32 | animal) * 0x9E3779B97F4A7C15ull;
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ull;
+    return static_cast<uint32_t>(x >> 32);
+}
+
+// The behaviors of hierarchical_inheritance.cpp and multilevel_inheritance.cpp, one frame's worth each
+inline void eat(AnimalState& a, uint32_t r) { a.energy += 0.01f + (r & 0xFF) * 1e-4f; }
+inline void sleep(AnimalState& a) { a.energy += 0.05f; }
+inline void breathe(AnimalState& a) {
+    ++a.breaths;
+    a.energy -= 0.02f;
+}
+inline void bark(AnimalState& a, const AnimalState& neighbor) { a.sounds += neighbor.energy < 0.5f; }
+inline void meow(AnimalState& a, uint32_t r) { a.sounds += (r >> 8 & 3) == 0; }
+inline void fly(AnimalState& a) {
+    a.altitude = a.altitude > 100.0f ? 0.0f : a.altitude + 1.5f;
+}
+
+// The simulation: animals, the per-frame task graph over them, and a per-frame summary
+class Simulation {
+private:
+    vector<AnimalState> animals;
+    size_t batch;
+    size_t batches;
+    uint32_t frame = 0;
+    vector<uint64_t> batchSounds;  // written by act[b], read by the summary
+    TaskGraph graph;
+
+    pair<size_t, size_t> range(size_t b) const { return {b * batch, min(animals.size(), (b + 1) * batch)}; }
+
+public:
+    uint64_t totalSounds = 0;  // running sum, updated by the summary task
+
+    Simulation(size_t count, size_t batchSize) : animals(count), batch(batchSize) {
+        if (batch == 0) {
+            throw invalid_argument("batch size must be at least 1");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t r = noise(UINT32_MAX, static_cast<uint32_t>(i));
+            animals[i] = {static_cast<Species>(r % 3), (r >> 8 & 0xFF) / 255.0f, 0, 0, 0.0f};
+        }
+        batches = (count + batch - 1) / batch;
+        batchSounds.assign(batches, 0);
+
+        vector<uint32_t> needs(batches), breathes(batches), acts(batches);
+        for (size_t b = 0; b < batches; ++b) {
+            needs[b] = graph.add("needs " + to_string(b), [this, b] {
+                auto [begin, end] = range(b);
+                for (size_t i = begin; i < end; ++i) {
+                    if (animals[i].energy < 0.3f) {
+                        sleep(animals[i]);
+                    } else {
+                        eat(animals[i], noise(frame, static_cast<uint32_t>(i)));
+                    }
+                }
+            });
+            breathes[b] = graph.add("breathe " + to_string(b), [this, b] {
+                auto [begin, end] = range(b);
+                for (size_t i = begin; i < end; ++i) {
+                    if (animals[i].species != Species::Bird) {
+                        breathe(animals[i]);
+                    }
+                }
+            });
+            acts[b] = graph.add("act " + to_string(b), [this, b] {
+                auto [begin, end] = range(b);
+                uint64_t before = 0, after = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    AnimalState& a = animals[i];
+                    before += a.sounds;
+                    switch (a.species) {
+                        case Species::Dog: bark(a, animals[(i + 1) % animals.size()]); break;
+                        case Species::Cat: meow(a, noise(frame, static_cast<uint32_t>(i))); break;
+                        case Species::Bird: fly(a); break;
+                    }
+                    after += a.sounds;
+                }
+                batchSounds[b] = after - before;
+            });
+            graph.precede(needs[b], breathes[b]);
+            graph.precede(breathes[b], acts[b]);
+        }
+        // A dog at the end of batch b looks at the first animal of the next batch (wrapping around)
+        for (size_t b = 0; b < batches; ++b) {
+            size_t next = (b + 1) % batches;
+            if (next != b) {
+                graph.precede(breathes[next], acts[b]);
+            }
+        }
+        uint32_t summary = graph.add("summary", [this] {
+            for (uint64_t s : batchSounds) {
+                totalSounds += s;
+            }
+            ++frame;
+        });
+        for (uint32_t act : acts) {
+            graph.precede(act, summary);
+        }
+    }
+
+    const TaskGraph& frameGraph() const { return graph; }
+
+    // A fingerprint of the complete state
+    uint64_t checksum() const {
+        uint64_t h = totalSounds;
+        for (const AnimalState& a : animals) {
+            uint32_t bits[2];
+            memcpy(&bits[0], &a.energy, 4);
+            memcpy(&bits[1], &a.altitude, 4);
+            h = (h ^ bits[0]) * 0x100000001B3ull;
+            h = (h ^ bits[1] ^ uint64_t(a.breaths) << 32 ^ a.sounds) * 0x100000001B3ull;
+        }
+        return h;
+    }
+};
+
+// ---------- BENCHMARK ----------
+
+// argv[index] as an integer clamped to [lo, hi], or fallback when it is absent
+static long long argument(int argc, char* argv[], int index, long long fallback, long long lo, long long hi) {
+    long long value = argc > index ? strtoll(argv[index], nullptr, 10) : fallback;
+    return min(max(value, lo), hi);
+}
+
+int main(int argc, char* argv[]) {
+    // A tiny frame, recorded on two threads and replayed serially
+    {
+        WorkStealingPool pool(2);
+        Executor executor(pool);
+        Simulation live(12, 4), replayed(12, 4);
+        Trace trace;
+        executor.run(live.frameGraph(), &trace);
+        cout << "Frame of 12 animals in batches of 4, tasks started in this order:" << endl;
+        for (uint32_t task : trace) {
+            cout << "  " << live.frameGraph().name(task) << endl;
+        }
+        Executor::replay(replayed.frameGraph(), trace);
+        cout << "Replay reproduces the frame: " << (live.checksum() == replayed.checksum() ? "yes" : "no") << endl;
+    }
+
+    const size_t n = static_cast<size_t>(argument(argc, argv, 1, 1000000, 1, LLONG_MAX));
+    const int frames = static_cast<int>(argument(argc, argv, 2, 100, 1, INT_MAX));
+    const unsigned maxThreads = static_cast<unsigned>(argument(argc, argv, 3, thread::hardware_concurrency(), 1, 256));
+
+    // Reference: the whole run on one thread with one batch per frame
+    uint64_t reference;
+    {
+        WorkStealingPool pool(1);
+        Executor executor(pool);
+        Simulation sim(n, n);
+        for (int f = 0; f < frames; ++f) {
+            executor.run(sim.frameGraph());
+        }
+        reference = sim.checksum();
+    }
+
+    printf("\n%zu animals, %d frames, %u hardware threads\n", n, frames, thread::hardware_concurrency());
+    printf("%8s %8s %7s %14s %10s %10s %10s %s\n", "threads", "batch", "tasks", "animals/s", "p50 ms", "p99 ms",
+           "max ms", "state");
+    vector<unsigned> threadCounts;  // 1, 2, 4, ... and always maxThreads
+    for (unsigned t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+    for (size_t batch : {size_t(1024), size_t(16384)}) {
+        for (unsigned threads : threadCounts) {
+            WorkStealingPool pool(threads);
+            Executor executor(pool);
+            Simulation sim(n, batch);
+            vector<double> frameMs;
+            for (int f = 0; f < frames; ++f) {
+                auto start = chrono::steady_clock::now();
+                executor.run(sim.frameGraph());
+                frameMs.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            }
+            double total = 0;
+            for (double ms : frameMs) {
+                total += ms;
+            }
+            sort(frameMs.begin(), frameMs.end());
+            auto percentile = [&](double p) { return frameMs[min(frameMs.size() - 1, size_t(p * frameMs.size()))]; };
+            printf("%8u %8zu %7zu %14.3g %10.2f %10.2f %10.2f %s\n", threads, batch, sim.frameGraph().size(),
+                   n * frames / (total / 1e3), percentile(0.5), percentile(0.99), frameMs.back(),
+                   sim.checksum() == reference ? "deterministic" : "DIFFERS");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,409 @@
+/*
+
+---------- COMPLEX ARRAY (STRUCTURE OF ARRAYS) ----------
+
+The Complex class in operator_overloading.cpp works on one value at a time. A buffer of a million samples stored as
+std::vector<Complex> is an "array of structures" (AoS): real and imaginary parts alternate in memory
+(r0 i0 r1 i1 r2 i2 ...). For SIMD that layout is awkward, because a complex multiply needs to combine the real parts
+of one register with the imaginary parts of another, which costs shuffles.
+
+ComplexArray stores the same data as a "structure of arrays" (SoA): one array with every real part and one with every
+imaginary part (r0 r1 r2 r3 ... / i0 i1 i2 i3 ...). Now 4 consecutive real parts sit in one 256-bit AVX register
+(2 in a 128-bit SSE2 register), and a complex multiply of 4 samples is just 4 multiplies and 2 adds/subtracts of
+whole registers, with no shuffles at all.
+
+---------- KERNELS ----------
+
+add(a, b, out): out[i] = a[i] + b[i]
+mul(a, b, out): out[i] = a[i] * b[i]           (complex multiply)
+scale(a, s, out): out[i] = a[i] * s            (real scalar)
+conj(a, out): out[i] = conjugate of a[i]
+magnitude(a, out): out[i] = |a[i]|             (sqrt(re^2 + im^2))
+dot(a, b): sum of a[i] * b[i]
+
+---------- BIT COMPATIBILITY ----------
+
+Every kernel performs exactly the same floating-point operations, in the same order, as the scalar Complex
+operators below, so the results are bit-for-bit identical. Two things matter:
+
+FMA Contraction: The compiler must not fuse a*b - c*d into a fused multiply-add in one version but not the other.
+                 When targeting FMA hardware (-march=native, -mfma) compile with -ffp-contract=off, and also with
+                 -fno-tree-vectorize: GCC 12 auto-vectorizes the scalar complex multiply into vfmaddsub even with
+                 contraction disabled. The kernels below use explicit vectors and are unaffected by that flag.
+Dot Product: A vector dot product keeps LANES partial sums, one per SIMD lane, and adds them at the end. The scalar
+             reference dotScalar() uses the same LANES partial sums so the summation order is identical.
+
+---------- RULES AND GUIDELINES ----------
+
+SoA For Bulk Work: Use ComplexArray for whole-buffer operations and Complex for single values.
+Where It Pays: dot gains the most (about 2x in-cache on the reference machine, 1.3-2x out of cache), and mul gains
+               in-cache with AVX. add, scale and conj do the same element-wise work in either layout. The compiler
+               auto-vectorizes the AoS loop for them, and in the SSE2 build that loop was 2-3x faster in-cache. Out of
+               cache every kernel except dot ran at memory speed in both layouts. Measure on the target with the
+               table main() prints before switching layouts for these kernels.
+Same Length: Two-input kernels throw invalid_argument when the input sizes differ. Each kernel resizes its output
+             to the input size, and the output may be one of the inputs (in-place).
+Compile: g++ -std=c++17 -O2 complex_array_simd.cpp
+         g++ -std=c++17 -O2 -mavx2 -mfma -ffp-contract=off -fno-tree-vectorize complex_array_simd.cpp
+Run: ./a.out [samples]   (default: one in-cache and one out-of-cache buffer)
+
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+// Complex from operator_overloading.cpp with complex multiply, divide, conjugate and abs added
+class Complex {
+private:
+    double real;
+    double imaginary;
+
+public:
+    Complex(double r = 0.0, double i = 0.0) : real(r), imaginary(i) {}
+
+    Complex operator+(const Complex& other) const {
+        return Complex(real + other.real, imaginary + other.imaginary);
+    }
+
+    Complex operator-(const Complex& other) const {
+        return Complex(real - other.real, imaginary - other.imaginary);
+    }
+
+    Complex operator*(double scalar) const {
+        return Complex(real * scalar, imaginary * scalar);
+    }
+
+    // (a + bi)(c + di) = (ac - bd) + (ad + bc)i
+    Complex operator*(const Complex& other) const {
+        return Complex(real * other.real - imaginary * other.imaginary,
+                       real * other.imaginary + imaginary * other.real);
+    }
+
+    // (a + bi) / (c + di) = ((ac + bd) + (bc - ad)i) / (c^2 + d^2)
+    Complex operator/(const Complex& other) const {
+        double denom = other.real * other.real + other.imaginary * other.imaginary;
+        return Complex((real * other.real + imaginary * other.imaginary) / denom,
+                       (imaginary * other.real - real * other.imaginary) / denom);
+    }
+
+    Complex conj() const {
+        return Complex(real, -imaginary);
+    }
+
+    double abs() const {
+        return sqrt(real * real + imaginary * imaginary);
+    }
+
+    bool operator==(const Complex& other) const {
+        return (real == other.real) && (imaginary == other.imaginary);
+    }
+
+    bool operator!=(const Complex& other) const {
+        return !(*this == other);
+    }
+
+    friend ostream& operator<<(ostream& os, const Complex& obj);
+
+    double getReal() const {
+        return real;
+    }
+
+    double getImaginary() const {
+        return imaginary;
+    }
+};
+
+ostream& operator<<(ostream& os, const Complex& obj) {
+    os << obj.real << " + " << obj.imaginary << "i";
+    return os;
+}
+
+// Split real/imaginary storage
+class ComplexArray {
+private:
+    vector<double> re;
+    vector<double> im;
+
+public:
+    ComplexArray() = default;
+    explicit ComplexArray(size_t n) : re(n), im(n) {}
+
+    size_t size() const { return re.size(); }
+
+    void resize(size_t n) {
+        re.resize(n);
+        im.resize(n);
+    }
+
+    void push_back(const Complex& c) {
+        re.push_back(c.getReal());
+        im.push_back(c.getImaginary());
+    }
+
+    Complex get(size_t i) const { return Complex(re[i], im[i]); }
+
+    void set(size_t i, const Complex& c) {
+        re[i] = c.getReal();
+        im[i] = c.getImaginary();
+    }
+
+    double* realData() { return re.data(); }
+    double* imagData() { return im.data(); }
+    const double* realData() const { return re.data(); }
+    const double* imagData() const { return im.data(); }
+};
+
+// ---------- SIMD KERNELS ----------
+
+// GCC/Clang vector extension sized to the widest register available: 4 doubles with AVX, 2 with SSE2
+#if defined(__AVX__)
+constexpr size_t LANES = 4;
+#else
+constexpr size_t LANES = 2;
+#endif
+typedef double Vec __attribute__((vector_size(LANES * sizeof(double))));
+
+static inline Vec load(const double* p) {
+    Vec v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store(double* p, Vec v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static void requireSameSize(const ComplexArray& a, const ComplexArray& b) {
+    if (a.size() != b.size()) {
+        throw invalid_argument("ComplexArray sizes differ");
+    }
+}
+
+void add(const ComplexArray& a, const ComplexArray& b, ComplexArray& out) {
+    requireSameSize(a, b);
+    out.resize(a.size());
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData(), *br = b.realData(), *bi = b.imagData();
+    double *orr = out.realData(), *oi = out.imagData();
+    for (; i + LANES <= n; i += LANES) {
+        store(orr + i, load(ar + i) + load(br + i));
+        store(oi + i, load(ai + i) + load(bi + i));
+    }
+    for (; i < n; ++i) {
+        orr[i] = ar[i] + br[i];
+        oi[i] = ai[i] + bi[i];
+    }
+}
+
+void mul(const ComplexArray& a, const ComplexArray& b, ComplexArray& out) {
+    requireSameSize(a, b);
+    out.resize(a.size());
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData(), *br = b.realData(), *bi = b.imagData();
+    double *orr = out.realData(), *oi = out.imagData();
+    for (; i + LANES <= n; i += LANES) {
+        Vec xr = load(ar + i), xi = load(ai + i), yr = load(br + i), yi = load(bi + i);
+        store(orr + i, xr * yr - xi * yi);
+        store(oi + i, xr * yi + xi * yr);
+    }
+    for (; i < n; ++i) {
+        double xr = ar[i], xi = ai[i], yr = br[i], yi = bi[i];
+        orr[i] = xr * yr - xi * yi;
+        oi[i] = xr * yi + xi * yr;
+    }
+}
+
+void scale(const ComplexArray& a, double s, ComplexArray& out) {
+    out.resize(a.size());
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData();
+    double *orr = out.realData(), *oi = out.imagData();
+    for (; i + LANES <= n; i += LANES) {
+        store(orr + i, load(ar + i) * s);
+        store(oi + i, load(ai + i) * s);
+    }
+    for (; i < n; ++i) {
+        orr[i] = ar[i] * s;
+        oi[i] = ai[i] * s;
+    }
+}
+
+void conj(const ComplexArray& a, ComplexArray& out) {
+    out.resize(a.size());
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData();
+    double *orr = out.realData(), *oi = out.imagData();
+    for (; i + LANES <= n; i += LANES) {
+        store(orr + i, load(ar + i));
+        store(oi + i, -load(ai + i));
+    }
+    for (; i < n; ++i) {
+        orr[i] = ar[i];
+        oi[i] = -ai[i];
+    }
+}
+
+void magnitude(const ComplexArray& a, vector<double>& out) {
+    out.resize(a.size());
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData();
+    double* o = out.data();
+    // The squares vectorize; sqrt is correctly rounded, so the per-element call gives the same bits
+    for (; i + LANES <= n; i += LANES) {
+        Vec xr = load(ar + i), xi = load(ai + i);
+        Vec sq = xr * xr + xi * xi;
+        for (size_t l = 0; l < LANES; ++l) {
+            o[i + l] = sqrt(sq[l]);
+        }
+    }
+    for (; i < n; ++i) {
+        o[i] = sqrt(ar[i] * ar[i] + ai[i] * ai[i]);
+    }
+}
+
+Complex dot(const ComplexArray& a, const ComplexArray& b) {
+    requireSameSize(a, b);
+    size_t n = a.size(), i = 0;
+    const double *ar = a.realData(), *ai = a.imagData(), *br = b.realData(), *bi = b.imagData();
+    Vec sr = {}, si = {};
+    for (; i + LANES <= n; i += LANES) {
+        Vec xr = load(ar + i), xi = load(ai + i), yr = load(br + i), yi = load(bi + i);
+        sr += xr * yr - xi * yi;
+        si += xr * yi + xi * yr;
+    }
+    Complex sum;
+    for (size_t l = 0; l < LANES; ++l) {
+        sum = sum + Complex(sr[l], si[l]);
+    }
+    for (; i < n; ++i) {
+        sum = sum + a.get(i) * b.get(i);
+    }
+    return sum;
+}
+
+// Scalar reference with the same LANES partial sums as dot()
+Complex dotScalar(const vector<Complex>& a, const vector<Complex>& b) {
+    size_t n = a.size(), i = 0;
+    Complex partial[LANES];
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t l = 0; l < LANES; ++l) {
+            partial[l] = partial[l] + a[i + l] * b[i + l];
+        }
+    }
+    Complex sum;
+    for (size_t l = 0; l < LANES; ++l) {
+        sum = sum + partial[l];
+    }
+    for (; i < n; ++i) {
+        sum = sum + a[i] * b[i];
+    }
+    return sum;
+}
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double msamplesPerSecond(size_t n, int repeats, F&& f) {
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        f();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return static_cast<double>(n) * repeats / seconds / 1e6;
+}
+
+static bool sameBits(double x, double y) {
+    return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+static bool sameBits(const Complex& x, const Complex& y) {
+    return sameBits(x.getReal(), y.getReal()) && sameBits(x.getImaginary(), y.getImaginary());
+}
+
+// Runs every kernel on n samples, prints throughput and returns false if any result differs from the scalar one
+bool runBenchmark(size_t n, int repeats) {
+    mt19937_64 rng(7);
+    uniform_real_distribution<double> dist(-10.0, 10.0);
+    vector<Complex> aos1, aos2;
+    ComplexArray soa1, soa2;
+    for (size_t i = 0; i < n; ++i) {
+        Complex x(dist(rng), dist(rng)), y(dist(rng), dist(rng));
+        aos1.push_back(x);
+        aos2.push_back(y);
+        soa1.push_back(x);
+        soa2.push_back(y);
+    }
+
+    vector<Complex> aosOut(n);
+    vector<double> aosMag(n), soaMag(n);
+    ComplexArray soaOut(n);
+    bool exact = true;
+    auto check = [&](const char* name) {
+        for (size_t i = 0; i < n; ++i) {
+            if (!sameBits(aosOut[i], soaOut.get(i))) {
+                cout << name << " differs at " << i << endl;
+                exact = false;
+                return;
+            }
+        }
+    };
+
+    printf("\n%zu samples\n%-10s %14s %14s   (Msamples/s)\n", n, "kernel", "scalar AoS", "SIMD SoA");
+
+    double s = msamplesPerSecond(n, repeats, [&] { for (size_t i = 0; i < n; ++i) aosOut[i] = aos1[i] + aos2[i]; });
+    double v = msamplesPerSecond(n, repeats, [&] { add(soa1, soa2, soaOut); });
+    check("add");
+    printf("%-10s %14.1f %14.1f\n", "add", s, v);
+
+    s = msamplesPerSecond(n, repeats, [&] { for (size_t i = 0; i < n; ++i) aosOut[i] = aos1[i] * aos2[i]; });
+    v = msamplesPerSecond(n, repeats, [&] { mul(soa1, soa2, soaOut); });
+    check("mul");
+    printf("%-10s %14.1f %14.1f\n", "mul", s, v);
+
+    s = msamplesPerSecond(n, repeats, [&] { for (size_t i = 0; i < n; ++i) aosOut[i] = aos1[i] * 2.5; });
+    v = msamplesPerSecond(n, repeats, [&] { scale(soa1, 2.5, soaOut); });
+    check("scale");
+    printf("%-10s %14.1f %14.1f\n", "scale", s, v);
+
+    s = msamplesPerSecond(n, repeats, [&] { for (size_t i = 0; i < n; ++i) aosOut[i] = aos1[i].conj(); });
+    v = msamplesPerSecond(n, repeats, [&] { conj(soa1, soaOut); });
+    check("conj");
+    printf("%-10s %14.1f %14.1f\n", "conj", s, v);
+
+    s = msamplesPerSecond(n, repeats, [&] { for (size_t i = 0; i < n; ++i) aosMag[i] = aos1[i].abs(); });
+    v = msamplesPerSecond(n, repeats, [&] { magnitude(soa1, soaMag); });
+    for (size_t i = 0; i < n && exact; ++i) {
+        exact = sameBits(aosMag[i], soaMag[i]);
+    }
+    printf("%-10s %14.1f %14.1f\n", "magnitude", s, v);
+
+    Complex ds, dv;
+    s = msamplesPerSecond(n, repeats, [&] { ds = dotScalar(aos1, aos2); });
+    v = msamplesPerSecond(n, repeats, [&] { dv = dot(soa1, soa2); });
+    exact = exact && sameBits(ds, dv);
+    printf("%-10s %14.1f %14.1f\n", "dot", s, v);
+
+    cout << "dot = " << dv << endl;
+    cout << "bit-compatible with scalar Complex: " << (exact ? "yes" : "NO") << endl;
+    return exact;
+}
+
+int main(int argc, char* argv[]) {
+    bool exact;
+    if (argc > 1) {
+        exact = runBenchmark(strtoull(argv[1], nullptr, 10), 20);
+    } else {
+        // +3 exercises the scalar tail; the first size fits in L1/L2, the second is memory bound
+        exact = runBenchmark(4096 + 3, 5000);
+        exact = runBenchmark((1u << 20) + 3, 20) && exact;
+    }
+    return exact ? 0 : 1;
+}
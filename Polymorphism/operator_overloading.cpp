@@ -32,45 +32,60 @@ Operators That Cannot Be Overloaded: . (dot), .* (pointer to member), :: (scope
 Overloaded Operator's Function Signature:
     Must be a non-static member function with at least one parameter of the class type.
     Or, it can be a non-member function with at least one parameter of the class type (using friend keyword).
+Constexpr Operators: Operators can be declared constexpr like any other function. Then expressions such as
+    Complex(0, 1) * Complex(0, 1) are evaluated by the compiler, and whole tables of Complex values can be built at
+    compile time instead of at program startup. This needs a literal type: a constexpr constructor and a trivial
+    destructor.
 
 */
 
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <string>
+#include <type_traits>
 using namespace std;
 
 // Class definition
 class Complex {
 private:
-    double real;
-    double imaginary;
+    double real = 0.0;
+    double imaginary = 0.0;
 
 public:
-    // Constructor
-    Complex(double r, double i) : real(r), imaginary(i) {}
+    // Constructors
+    Complex() = default;
+    constexpr Complex(double r, double i) noexcept : real(r), imaginary(i) {}
 
     // Overloaded + operator to add two Complex objects
-    Complex operator+(const Complex& other) const {
+    constexpr Complex operator+(const Complex& other) const noexcept {
         return Complex(real + other.real, imaginary + other.imaginary);
     }
 
     // Overloaded - operator to subtract two Complex objects
-    Complex operator-(const Complex& other) const {
+    constexpr Complex operator-(const Complex& other) const noexcept {
         return Complex(real - other.real, imaginary - other.imaginary);
     }
 
     // Overloaded * operator to multiply with a scalar
-    Complex operator*(double scalar) const {
+    constexpr Complex operator*(double scalar) const noexcept {
         return Complex(real * scalar, imaginary * scalar);
     }
 
+    // Overloaded * operator to multiply two Complex objects
+    constexpr Complex operator*(const Complex& other) const noexcept {
+        return Complex(real * other.real - imaginary * other.imaginary,
+                       real * other.imaginary + imaginary * other.real);
+    }
+
     // Overloaded == operator to compare two Complex objects
-    bool operator==(const Complex& other) const {
+    constexpr bool operator==(const Complex& other) const noexcept {
         return (real == other.real) && (imaginary == other.imaginary);
     }
 
     // Overloaded != operator to compare two Complex objects
-    bool operator!=(const Complex& other) const {
+    constexpr bool operator!=(const Complex& other) const noexcept {
         return !(*this == other);
     }
 
@@ -78,21 +93,88 @@ public:
     friend ostream& operator<<(ostream& os, const Complex& obj);
 
     // Getter methods
-    double getReal() const {
+    constexpr double getReal() const noexcept {
         return real;
     }
 
-    double getImaginary() const {
+    constexpr double getImaginary() const noexcept {
         return imaginary;
     }
 };
 
+// Copying a Complex is a plain memcpy of two doubles
+static_assert(is_trivially_copyable<Complex>::value, "Complex must stay trivially copyable");
+static_assert(is_trivially_destructible<Complex>::value, "Complex must stay trivially destructible");
+static_assert(is_nothrow_copy_constructible<Complex>::value, "Complex copies must not throw");
+
 // Overloaded << operator to print Complex objects
 ostream& operator<<(ostream& os, const Complex& obj) {
     os << obj.real << " + " << obj.imaginary << "i";
     return os;
 }
 
+// std::sin and std::cos are not constexpr, so compile-time tables use a Taylor series instead.
+// The argument is first reduced to [-pi, pi]; the result agrees with std::sin/std::cos to ~1e-15.
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double reduceAngle(double x) {
+    while (x > PI) x -= 2 * PI;
+    while (x < -PI) x += 2 * PI;
+    return x;
+}
+
+constexpr double constexprSin(double x) {
+    x = reduceAngle(x);
+    double term = x, sum = x;
+    for (int n = 1; n < 30; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    x = reduceAngle(x);
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 30; ++n) {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Twiddle factors e^(-2*pi*i*k/N), evaluated by the compiler
+template <size_t N>
+constexpr array<Complex, N> makeTwiddleTable() {
+    array<Complex, N> table{};
+    for (size_t k = 0; k < N; ++k) {
+        double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(N);
+        table[k] = Complex(constexprCos(angle), constexprSin(angle));
+    }
+    return table;
+}
+
+// The same table built at startup, as it had to be before Complex was constexpr
+template <size_t N>
+array<Complex, N> makeTwiddleTableAtRuntime() {
+    array<Complex, N> table{};
+    for (size_t k = 0; k < N; ++k) {
+        double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(N);
+        table[k] = Complex(cos(angle), sin(angle));
+    }
+    return table;
+}
+
+constexpr size_t TABLE_SIZE = 1024;
+constexpr array<Complex, TABLE_SIZE> twiddles = makeTwiddleTable<TABLE_SIZE>();
+
+// Operators are checked by the compiler too
+constexpr Complex imaginaryUnit(0.0, 1.0);
+static_assert(imaginaryUnit * imaginaryUnit == Complex(-1.0, 0.0), "i squared is -1");
+static_assert(Complex() == Complex(0.0, 0.0), "default Complex is zero");
+static_assert(Complex(3.0, 4.0) + Complex(1.0, -1.0) == Complex(4.0, 3.0), "constexpr addition");
+static_assert(twiddles[0] == Complex(1.0, 0.0), "first twiddle is 1");
+
 int main() {
     // Create two Complex objects
     Complex c1(3.0, 4.0);
@@ -102,6 +184,7 @@ int main() {
     Complex sum = c1 + c2;
     Complex difference = c1 - c2;
     Complex scaled = c1 * 2.0;
+    Complex product = c1 * c2;
 
     // Print results
     cout << "c1: " << c1 << endl;
@@ -109,6 +192,7 @@ int main() {
     cout << "Sum: " << sum << endl;
     cout << "Difference: " << difference << endl;
     cout << "Scaled c1: " << scaled << endl;
+    cout << "Product: " << product << endl;
 
     // Test == and != operators
     if (c1 == c2) {
@@ -117,5 +201,19 @@ int main() {
         cout << "c1 is not equal to c2" << endl;
     }
 
+    // The constexpr table costs nothing at startup; the runtime one has to call cos/sin for every entry
+    auto start = chrono::steady_clock::now();
+    array<Complex, TABLE_SIZE> runtimeTable = makeTwiddleTableAtRuntime<TABLE_SIZE>();
+    double runtimeNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    double maxDiff = 0.0;
+    for (size_t k = 0; k < TABLE_SIZE; ++k) {
+        Complex d = twiddles[k] - runtimeTable[k];
+        maxDiff = max(maxDiff, max(fabs(d.getReal()), fabs(d.getImaginary())));
+    }
+
+    cout << "Twiddle table of " << TABLE_SIZE << " entries built at startup in " << runtimeNs
+         << " ns; compile-time table: 0 ns (max difference " << maxDiff << ")" << endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,434 @@
+/*
+
+---------- DISPATCH BENCHMARK ----------
+
+super_keyword.cpp calls Base::display() from Derived::callBaseDisplay(): a qualified call, bound at compile time.
+function_overriding.cpp calls display() through a Base*: a virtual call, bound at run time through the vtable.
+Between and around those two sit several other ways to reach the same function, and their costs differ by whether
+the compiler can see the target, and so inline it, or has to jump through a pointer:
+
+direct: A non-virtual member function, d.show(x).
+qualified_base: A virtual function called with its class named, d.Base::display(x) as in callBaseDisplay(); no vtable.
+virtual: p->display(x) through a Base* whose dynamic type the caller cannot see.
+virtual_mixed: The same, with the pointers alternating randomly between two derived classes, so the branch predictor
+               cannot learn the target.
+final: A call through a FinalDerived& obtained from another translation unit. The caller cannot see the object,
+       but the class is marked final, so no override can exist and the compiler calls the function directly
+       ("devirtualization").
+nonfinal_ref: The control for final: the same call through a Derived& from another translation unit, which stays
+              virtual because Derived could have subclasses.
+crtp: A template base calling the derived class through static_cast (curiously recurring template pattern); always
+      visible to the compiler, so always inlinable.
+std_function: A call through std::function, which hides the target behind a type-erased pointer.
+
+---------- BUILD VARIANTS ----------
+
+What the compiler can see depends on how the program is built, so the same calls are measured in several builds:
+
+as_built: This binary, usually compiled as one translation unit: every body is visible.
+split: The classes and the measuring loops compiled as two translation units, as in a real project.
+split_lto: The same with link-time optimization (-flto), which lets the optimizer inline across the two units.
+split_pgo: Profile-guided optimization: built with -fprofile-generate, run once to record which targets are called,
+           rebuilt with -fprofile-use. GCC then turns a virtual call that always hits one target into a compare and
+           a direct (inlinable) call.
+split_lto_pgo: Both.
+
+With --variants the program builds the split variants itself from this source file (one file stands in for the
+missing build system) and runs each of them. The source is found through __FILE__, which is relative to the
+directory the program was compiled from; run elsewhere, pass --source PATH. A variant that fails to build or run is
+an error: the exit status is 1. --quick measures 100 times fewer calls as a smoke test of the as-built binary; it
+cannot be combined with --variants, because a gate must not silently lose the variants.
+
+---------- OUTPUT ----------
+
+One JSON document on stdout, so the results can be stored and compared between builds:
+{"compiler": "...", "variants": [{"variant": "split_lto", "flags": "-O2 -flto=auto",
+                                   "results": [{"benchmark": "virtual", "ns": 1.52}, ...]}, ...]}
+With --baseline FILE the results are compared against an earlier document; any call that got slower than the
+tolerance allows, and any result in the baseline that this run did not produce, is reported on stderr and the exit
+status is 1, so the run can gate a change.
+
+---------- RULES AND GUIDELINES ----------
+
+Measure The Build You Ship: Devirtualization and inlining depend on LTO and PGO; numbers from one build say little
+                            about another.
+Prefer final And Templates On Hot Paths: They give the compiler the target without relying on the build.
+Compile: g++ -std=c++17 -O2 dispatch_benchmark.cpp
+Run: ./a.out [--variants [--source PATH]] [--baseline dispatch.json [--tolerance 0.15]] [--quick]
+     (CXX selects the compiler used by --variants, default g++)
+
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// DISPATCH_TU selects one half of the program for the split builds: 1 = the classes, 2 = the measuring code.
+// Undefined means both, in one translation unit.
+#if !defined(DISPATCH_TU)
+#define DISPATCH_CLASSES 1
+#define DISPATCH_MAIN 1
+#elif DISPATCH_TU == 1
+#define DISPATCH_CLASSES 1
+#define DISPATCH_MAIN 0
+#else
+#define DISPATCH_CLASSES 0
+#define DISPATCH_MAIN 1
+#endif
+
+// ---------- CLASSES (declarations seen by both halves) ----------
+
+// The work every call does, small enough that the call itself dominates
+inline int work(int& calls, int x) {
+    ++calls;
+    return x ^ calls;
+}
+
+class Base {
+public:
+    int calls = 0;
+
+    virtual ~Base();
+    virtual int display(int x);
+};
+
+class Derived : public Base {
+public:
+    int display(int x) override;
+    int show(int x);  // non-virtual
+};
+
+class OtherDerived : public Base {
+public:
+    int display(int x) override;
+};
+
+class FinalDerived final : public Base {
+public:
+    int display(int x) override;
+};
+
+template <typename D>
+class CrtpBase {
+public:
+    int display(int x) { return static_cast<D*>(this)->displayImpl(x); }
+};
+
+class CrtpDerived : public CrtpBase<CrtpDerived> {
+public:
+    int calls = 0;
+    int displayImpl(int x) { return work(calls, x); }
+};
+
+// Factories live with the classes, so in the split builds the caller cannot see the dynamic types
+Base* makeDerived();
+Base* makeOtherDerived();
+FinalDerived& makeFinalDerived();
+Derived& makeDerivedReference();
+function<int(int)> makeDisplayFunction(Derived& d);
+
+// ---------- CLASSES (definitions) ----------
+
+#if DISPATCH_CLASSES
+
+Base::~Base() = default;
+int Base::display(int x) { return work(calls, x); }
+int Derived::display(int x) { return work(calls, x) + 1; }
+int Derived::show(int x) { return work(calls, x); }
+int OtherDerived::display(int x) { return work(calls, x) + 2; }
+int FinalDerived::display(int x) { return work(calls, x) + 3; }
+
+Base* makeDerived() { return new Derived(); }
+Base* makeOtherDerived() { return new OtherDerived(); }
+FinalDerived& makeFinalDerived() {
+    static FinalDerived object;
+    return object;
+}
+Derived& makeDerivedReference() {
+    static Derived object;
+    return object;
+}
+function<int(int)> makeDisplayFunction(Derived& d) {
+    return [&d](int x) { return d.show(x); };
+}
+
+#endif
+
+// ---------- MEASUREMENT ----------
+
+#if DISPATCH_MAIN
+
+struct Result {
+    string benchmark;
+    double ns;
+};
+
+static volatile long sink = 0;
+
+// Best of 5 runs of `calls` calls to f(i), in ns per call
+template <typename F>
+double nsPerCall(long calls, F&& f) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = chrono::steady_clock::now();
+        long sum = 0;
+        for (long i = 0; i < calls; ++i) {
+            sum += f(static_cast<int>(i));
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / double(calls);
+        sink = sink + sum;
+        best = min(best, ns);
+    }
+    return best;
+}
+
+vector<Result> measure(long calls) {
+    Derived derived;
+    FinalDerived& finalDerived = makeFinalDerived();
+    Derived& derivedReference = makeDerivedReference();
+    CrtpDerived crtp;
+    Base* one = makeDerived();
+    Base* other = makeOtherDerived();
+    function<int(int)> fn = makeDisplayFunction(derived);
+
+    // A random but fixed sequence of the two derived classes for virtual_mixed
+    vector<Base*> mixed(4096);
+    mt19937 rng(5);
+    for (Base*& p : mixed) {
+        p = rng() & 1 ? one : other;
+    }
+
+    vector<Result> results;
+    results.push_back({"direct", nsPerCall(calls, [&](int x) { return derived.show(x); })});
+    results.push_back({"qualified_base", nsPerCall(calls, [&](int x) { return derived.Base::display(x); })});
+    results.push_back({"virtual", nsPerCall(calls, [&](int x) { return one->display(x); })});
+    results.push_back({"virtual_mixed", nsPerCall(calls, [&](int x) { return mixed[x & 4095]->display(x); })});
+    results.push_back({"final", nsPerCall(calls, [&](int x) { return finalDerived.display(x); })});
+    results.push_back({"nonfinal_ref", nsPerCall(calls, [&](int x) { return derivedReference.display(x); })});
+    results.push_back({"crtp", nsPerCall(calls, [&](int x) { return crtp.display(x); })});
+    results.push_back({"std_function", nsPerCall(calls, [&](int x) { return fn(x); })});
+
+    delete one;
+    delete other;
+    return results;
+}
+
+string variantJson(const string& name, const string& flags, const vector<Result>& results) {
+    ostringstream out;
+    out << "    {\"variant\": \"" << name << "\", \"flags\": \"" << flags << "\", \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        char ns[32];
+        snprintf(ns, sizeof ns, "%.3f", results[i].ns);
+        out << (i ? ", " : "") << "{\"benchmark\": \"" << results[i].benchmark << "\", \"ns\": " << ns << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+// ---------- SELF-BUILT VARIANTS ----------
+
+struct BuildVariant {
+    const char* name;
+    const char* flags;
+    bool pgo;
+};
+
+int shell(const string& command) { return system(command.c_str()); }
+
+// Builds the source as two translation units with the given flags and runs the result; returns its variant JSON,
+// or "" when it could not be built or did not run cleanly
+string buildAndRun(const BuildVariant& v, const string& source, const filesystem::path& dir) {
+    const char* cxx = getenv("CXX");
+    const string compiler = cxx ? cxx : "g++";
+    const string exe = (dir / v.name).string();
+    const string profile = (dir / (string(v.name) + "_profile")).string();
+    auto build = [&](const string& extra) {
+        string common = compiler + " -std=c++17 " + v.flags + " " + extra;
+        string classes = (dir / (string(v.name) + "_classes.o")).string();
+        string main = (dir / (string(v.name) + "_main.o")).string();
+        return shell(common + " -DDISPATCH_TU=1 -c \"" + source + "\" -o \"" + classes + "\"") == 0 &&
+               shell(common + " -DDISPATCH_TU=2 -c \"" + source + "\" -o \"" + main + "\"") == 0 &&
+               shell(common + " \"" + classes + "\" \"" + main + "\" -o \"" + exe + "\"") == 0;
+    };
+    bool built = v.pgo ? build("-fprofile-generate=\"" + profile + "\"") &&
+                             shell("\"" + exe + "\" --train-profile") == 0 &&
+                             build("-fprofile-use=\"" + profile + "\" -Wno-missing-profile")
+                       : build("");
+    if (!built) {
+        fprintf(stderr, "could not build variant %s\n", v.name);
+        return "";
+    }
+    string command = "\"" + exe + "\" --emit-variant " + v.name + " \"" + v.flags + (v.pgo ? " +pgo" : "") + "\"";
+    string json;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        fprintf(stderr, "could not run variant %s\n", v.name);
+        return "";
+    }
+    char buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof buffer, pipe)) > 0;) {
+        json.append(buffer, n);
+    }
+    if (pclose(pipe) != 0 || json.find("\"results\"") == string::npos) {
+        fprintf(stderr, "variant %s did not run cleanly\n", v.name);
+        return "";
+    }
+    while (!json.empty() && json.back() == '\n') {
+        json.pop_back();
+    }
+    return json;
+}
+
+// ---------- REGRESSION GATE ----------
+
+// (variant, benchmark) -> ns from a document printed by this program
+map<pair<string, string>, double> readResults(const string& json) {
+    map<pair<string, string>, double> results;
+    auto stringAfter = [&](size_t at) {
+        size_t start = json.find('"', json.find(':', at)) + 1;
+        return json.substr(start, json.find('"', start) - start);
+    };
+    string variant;
+    for (size_t at = 0; at < json.size();) {
+        size_t v = json.find("\"variant\"", at), b = json.find("\"benchmark\"", at);
+        if (v == string::npos && b == string::npos) {
+            break;
+        }
+        if (v < b) {
+            variant = stringAfter(v);
+            at = v + 1;
+        } else {
+            string benchmark = stringAfter(b);
+            size_t ns = json.find("\"ns\"", b);
+            results[{variant, benchmark}] = strtod(json.c_str() + json.find(':', ns) + 1, nullptr);
+            at = b + 1;
+        }
+    }
+    return results;
+}
+
+// Returns the number of results slower than the baseline allows or missing from this run
+int compareWithBaseline(const string& current, const string& baselineFile, double tolerance) {
+    ifstream in(baselineFile);
+    if (!in) {
+        fprintf(stderr, "cannot read baseline %s\n", baselineFile.c_str());
+        return 1;
+    }
+    stringstream text;
+    text << in.rdbuf();
+    auto baseline = readResults(text.str());
+    if (baseline.empty()) {
+        fprintf(stderr, "baseline %s holds no results\n", baselineFile.c_str());
+        return 1;
+    }
+    auto results = readResults(current);
+    int regressions = 0;
+    for (const auto& [key, old] : baseline) {
+        auto now = results.find(key);
+        if (now == results.end()) {
+            fprintf(stderr, "missing: %s/%s is in the baseline but was not measured\n", key.first.c_str(),
+                    key.second.c_str());
+            ++regressions;
+        } else if (now->second > old * (1 + tolerance) + 0.25) {
+            // 0.25 ns of absolute slack keeps sub-nanosecond timer noise from failing the gate
+            fprintf(stderr, "regression: %s/%s %.3f ns -> %.3f ns\n", key.first.c_str(), key.second.c_str(), old,
+                    now->second);
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char* argv[]) {
+    bool variants = false, quick = false;
+    string baselineFile;
+    string source = __FILE__;
+    double tolerance = 0.15;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--variants") {
+            variants = true;
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselineFile = argv[++i];
+        } else if (arg == "--source" && i + 1 < argc) {
+            source = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (arg == "--train-profile") {
+            // Used by --variants: the PGO training run, which only has to call every target
+            measure(200000);
+            return 0;
+        } else if (arg == "--emit-variant" && i + 2 < argc) {
+            // Used by --variants: print only this build's variant object
+            printf("%s\n", variantJson(argv[i + 1], argv[i + 2], measure(20000000)).c_str());
+            return 0;
+        } else {
+            fprintf(stderr, "usage: %s [--variants [--source PATH]] [--baseline FILE [--tolerance 0.15]] [--quick]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (variants && quick) {
+        fprintf(stderr, "--quick cannot be combined with --variants: the split variants are only measured in full\n");
+        return 2;
+    }
+    if (variants && !filesystem::exists(source)) {
+        fprintf(stderr, "source file %s not found (it is relative to where the program was compiled); "
+                        "pass --source PATH\n", source.c_str());
+        return 1;
+    }
+
+    const long calls = quick ? 200000 : 20000000;
+    vector<string> objects = {variantJson("as_built", "as compiled", measure(calls))};
+    int failedVariants = 0;
+    if (variants) {
+        const BuildVariant builds[] = {
+            {"split", "-O2", false},
+            {"split_lto", "-O2 -flto=auto", false},
+            {"split_pgo", "-O2", true},
+            {"split_lto_pgo", "-O2 -flto=auto", true},
+        };
+        filesystem::path dir = filesystem::temp_directory_path() / ("dispatch_benchmark_" + to_string(getpid()));
+        filesystem::create_directories(dir);
+        for (const BuildVariant& v : builds) {
+            string json = buildAndRun(v, source, dir);
+            if (json.empty()) {
+                ++failedVariants;
+            } else {
+                objects.push_back(json);
+            }
+        }
+        error_code ec;
+        filesystem::remove_all(dir, ec);
+    }
+
+    string document = "{\"compiler\": \"" + string(__VERSION__) + "\", \"variants\": [\n";
+    for (size_t i = 0; i < objects.size(); ++i) {
+        document += objects[i] + (i + 1 < objects.size() ? ",\n" : "\n");
+    }
+    document += "]}\n";
+    fputs(document.c_str(), stdout);
+
+    int failures = failedVariants;
+    if (!baselineFile.empty()) {
+        failures += compareWithBaseline(document, baselineFile, tolerance);
+    }
+    return failures ? 1 : 0;
+}
+
+#endif
@@ -33,22 +33,25 @@ Access Specifiers: Typically, getters and setters are public, while the data mem
 Naming Conventions: Common naming conventions are getVariableName for getters and setVariableName for setters.
 Const Correctness: Getters should be marked as const to ensure they do not modify the object.
 Validation Logic: Setters can include validation logic to ensure data integrity.
+Avoid Copies: A getter for a string can return a string_view of the member instead of a copy. The view is only valid
+    while the object is alive and unchanged, so store a copy if you need to keep the value.
 
 */
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
 class Person {
 private:
     string name;
-    int age;
+    int age = 0;  // a default-constructed Person has a defined age
 
 public:
-    // Getter for name
-    string getName() const {
+    // Getter for name (a view of the stored string, no copy)
+    string_view getName() const {
         return name;
     }
 
@@ -0,0 +1,510 @@
+/*
+
+---------- STRING INTERNING ----------
+
+Person in getter_and_setter.cpp, Animal/Dog in Inheritance/single_inheritance.cpp and Person in
+multiple_inheritance.cpp each store their names as std::string. With millions of records the same few thousand names
+("John", "Canine", "Buddy"...) are stored millions of times: every copy costs 32 bytes for the string object plus a heap
+block for anything longer than the small-string buffer (15 characters in libstdc++).
+
+Interning stores every distinct string exactly once in a shared table and gives each object a small handle to it:
+
+1. Memory: A record holds a 4-byte id instead of a 32-byte string plus its heap block.
+2. Comparisons: Two interned strings are equal exactly when their ids are equal, one integer compare.
+3. Access: view() returns a string_view into the table; no copy, no allocation.
+
+---------- HOW IT WORKS ----------
+
+StringPool: Holds every distinct string once, in its own allocation that never moves, so string_views stay valid.
+            Interning hashes the text and locks only one of 64 shards, so threads interning different names rarely
+            wait on each other. Looking up the text of a handle takes no lock at all: the id indexes a two-level table
+            whose blocks are never moved or freed.
+InternedString: The handle. Copying it increments a per-string reference count; when the last handle of a string is
+                destroyed the string is removed from the pool and its id is reused. Moving a handle costs nothing.
+
+---------- USES ----------
+
+Names And Labels: Person names, animal types, tags, categories, country codes.
+Compilers And Interpreters: Identifiers and symbols are interned so lookups compare integers.
+Parsers And Loaders: Repeated keys in JSON, CSV or log files.
+
+---------- RULES AND GUIDELINES ----------
+
+Views Follow The Handle: A string_view from view() is valid as long as at least one handle to that string exists.
+Prefer Moves: Copying a handle is an atomic increment; pass by const reference or move where possible.
+Equality Only: Ids say nothing about alphabetical order; compare view()s for sorting.
+Compile: g++ -std=c++17 -O2 -pthread string_interning.cpp
+Run: ./a.out [records, default 5000000]   (50000000 for the full data set, about 3 GB for the std::string version)
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ---------- HEAP ACCOUNTING (for the memory comparison) ----------
+
+// Counts the usable size of every live heap block (glibc)
+static atomic<size_t> liveHeapBytes{0};
+
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw bad_alloc();
+    }
+    liveHeapBytes.fetch_add(malloc_usable_size(p), memory_order_relaxed);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        liveHeapBytes.fetch_sub(malloc_usable_size(p), memory_order_relaxed);
+        free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// ---------- STRING POOL ----------
+
+class InternedString;
+
+class StringPool {
+private:
+    // One distinct string; allocated once and never moved
+    struct Entry {
+        atomic<uint32_t> references;
+        uint32_t length;
+        char text[1];  // length characters follow
+
+        string_view view() const { return string_view(text, length); }
+    };
+
+    static constexpr size_t SHARDS = 64;
+    static constexpr size_t BLOCK_BITS = 16;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+    static constexpr size_t MAX_BLOCKS = (size_t(1) << 32) / BLOCK_SIZE;
+
+    struct alignas(64) Shard {
+        mutex lock;
+        unordered_map<string_view, uint32_t> ids;  // keys point into the entries' text
+    };
+
+    Shard shards[SHARDS];
+
+    // Id -> entry, two levels so blocks never move; readers need no lock
+    atomic<atomic<Entry*>*> blocks[MAX_BLOCKS] = {};
+
+    mutex idLock;
+    uint32_t nextId = 1;  // id 0 is the empty string and is never stored
+    vector<uint32_t> freeIds;
+
+    atomic<size_t> distinct{0};
+    atomic<size_t> textBytes{0};
+
+    Shard& shardFor(string_view text) { return shards[hash<string_view>()(text) % SHARDS]; }
+
+    atomic<Entry*>& slot(uint32_t id) const {
+        return blocks[id >> BLOCK_BITS].load(memory_order_acquire)[id & (BLOCK_SIZE - 1)];
+    }
+
+    uint32_t allocateId() {
+        lock_guard<mutex> guard(idLock);
+        if (!freeIds.empty()) {
+            uint32_t id = freeIds.back();
+            freeIds.pop_back();
+            return id;
+        }
+        uint32_t id = nextId++;
+        if (!blocks[id >> BLOCK_BITS].load(memory_order_relaxed)) {
+            void* memory = ::operator new(BLOCK_SIZE * sizeof(atomic<Entry*>));
+            blocks[id >> BLOCK_BITS].store(new (memory) atomic<Entry*>[BLOCK_SIZE](), memory_order_release);
+        }
+        return id;
+    }
+
+    void addReference(uint32_t id) {
+        if (id != 0) {
+            slot(id).load(memory_order_relaxed)->references.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    // Counts above 1 drop without a lock. The last reference is dropped under the shard lock, the same lock intern()
+    // holds when it revives an entry, so a count that reaches 0 here stays 0 and the entry can be freed safely.
+    void dropReference(uint32_t id) {
+        if (id == 0) {
+            return;
+        }
+        Entry* entry = slot(id).load(memory_order_acquire);  // alive: the caller still holds a reference
+        uint32_t count = entry->references.load(memory_order_relaxed);
+        while (count > 1) {
+            if (entry->references.compare_exchange_weak(count, count - 1, memory_order_acq_rel)) {
+                return;
+            }
+        }
+        Shard& shard = shardFor(entry->view());
+        {
+            lock_guard<mutex> guard(shard.lock);
+            if (entry->references.fetch_sub(1, memory_order_acq_rel) != 1) {
+                return;  // copied by another handle since the load above
+            }
+            shard.ids.erase(entry->view());
+            slot(id).store(nullptr, memory_order_relaxed);
+        }
+        distinct.fetch_sub(1, memory_order_relaxed);
+        textBytes.fetch_sub(entry->length, memory_order_relaxed);
+        ::operator delete(entry);
+        lock_guard<mutex> guard(idLock);
+        freeIds.push_back(id);
+    }
+
+    friend class InternedString;
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    ~StringPool() {
+        for (auto& block : blocks) {
+            atomic<Entry*>* entries = block.load(memory_order_relaxed);
+            if (!entries) {
+                break;
+            }
+            for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                ::operator delete(entries[i].load(memory_order_relaxed));
+            }
+            ::operator delete(entries);
+        }
+    }
+
+    // The process-wide pool used by InternedString
+    static StringPool& global() {
+        static StringPool pool;
+        return pool;
+    }
+
+    InternedString intern(string_view text);
+
+    string_view view(uint32_t id) const { return id == 0 ? string_view() : slot(id).load(memory_order_acquire)->view(); }
+
+    size_t distinctStrings() const { return distinct.load(memory_order_relaxed); }
+    size_t storedBytes() const { return textBytes.load(memory_order_relaxed); }
+};
+
+// Handle to a pooled string: 4 bytes, reference counted, equal ids <=> equal text
+class InternedString {
+private:
+    uint32_t id = 0;
+
+    struct Adopt {};
+    InternedString(uint32_t existing, Adopt) : id(existing) {}  // takes over a reference already counted
+
+    friend class StringPool;
+
+public:
+    InternedString() = default;
+    InternedString(string_view text) : InternedString(StringPool::global().intern(text)) {}
+
+    InternedString(const InternedString& other) : id(other.id) { StringPool::global().addReference(id); }
+    InternedString(InternedString&& other) noexcept : id(other.id) { other.id = 0; }
+
+    InternedString& operator=(InternedString other) noexcept {
+        swap(id, other.id);
+        return *this;
+    }
+
+    ~InternedString() { StringPool::global().dropReference(id); }
+
+    string_view view() const { return StringPool::global().view(id); }
+    uint32_t getId() const { return id; }
+
+    friend bool operator==(const InternedString& a, const InternedString& b) { return a.id == b.id; }
+    friend bool operator!=(const InternedString& a, const InternedString& b) { return a.id != b.id; }
+};
+
+InternedString StringPool::intern(string_view text) {
+    if (text.empty()) {
+        return InternedString();
+    }
+    Shard& shard = shardFor(text);
+    lock_guard<mutex> guard(shard.lock);
+    auto found = shard.ids.find(text);
+    if (found != shard.ids.end()) {
+        // Entries in the map always have a count above 0: the last reference is dropped under this lock
+        slot(found->second).load(memory_order_relaxed)->references.fetch_add(1, memory_order_relaxed);
+        return InternedString(found->second, InternedString::Adopt());
+    }
+
+    Entry* entry = static_cast<Entry*>(::operator new(offsetof(Entry, text) + text.size()));
+    new (&entry->references) atomic<uint32_t>(1);
+    entry->length = static_cast<uint32_t>(text.size());
+    memcpy(entry->text, text.data(), text.size());
+
+    uint32_t id = allocateId();
+    slot(id).store(entry, memory_order_release);
+    shard.ids[entry->view()] = id;
+    distinct.fetch_add(1, memory_order_relaxed);
+    textBytes.fetch_add(text.size(), memory_order_relaxed);
+    return InternedString(id, InternedString::Adopt());
+}
+
+// ---------- CLASSES WITH INTERNED NAMES ----------
+
+// Person from getter_and_setter.cpp
+class Person {
+private:
+    InternedString name;
+    int age = 0;
+
+public:
+    // Getter for name (a view into the pool, no copy)
+    string_view getName() const { return name.view(); }
+
+    // Setter for name
+    void setName(string_view newName) {
+        if (!newName.empty()) {
+            name = InternedString(newName);
+        }
+    }
+
+    int getAge() const { return age; }
+
+    void setAge(int newAge) {
+        if (newAge > 0) {
+            age = newAge;
+        }
+    }
+
+    bool sameName(const Person& other) const { return name == other.name; }
+};
+
+// Animal and Dog from Inheritance/single_inheritance.cpp
+class Animal {
+private:
+    InternedString type;
+
+public:
+    Animal(string_view t) : type(t) {}
+
+    void setType(string_view t) { type = InternedString(t); }
+    string_view getType() const { return type.view(); }
+};
+
+class Dog : public Animal {
+private:
+    InternedString name;
+
+public:
+    Dog(string_view t, string_view n) : Animal(t), name(n) {}
+
+    void setName(string_view n) { name = InternedString(n); }
+    string_view getName() const { return name.view(); }
+
+    void bark() const { cout << "Dog " << getName() << " is barking." << endl; }
+};
+
+// The original std::string version, for comparison
+class PlainPerson {
+private:
+    string name;
+    int age = 0;
+
+public:
+    string getName() const { return name; }
+    string_view getNameView() const { return name; }
+    void setName(const string& newName) { name = newName; }
+    void setAge(int newAge) { age = newAge; }
+};
+
+// ---------- BENCHMARK ----------
+
+// Names like "Firstname Lastnameson" with a skewed (Zipf-like) distribution: a few very common names, a long tail
+class NameGenerator {
+private:
+    vector<string> firsts, lasts;
+    mt19937_64 rng;
+
+    size_t skewed(size_t n) {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return static_cast<size_t>(double(n) * u * u * u);  // cubing concentrates picks near the front
+    }
+
+public:
+    explicit NameGenerator(uint64_t seed) : rng(seed) {
+        const char* syllables[] = {"an", "bel", "cor", "da", "el", "fin", "gar", "hol", "is", "jo",
+                                   "ka", "lin", "mar", "no", "or", "pet", "qui", "ros", "sa", "ty"};
+        for (int a = 0; a < 20; ++a) {
+            for (int b = 0; b < 20; ++b) {
+                string s = string(syllables[a]) + syllables[b];
+                s[0] = static_cast<char>(s[0] - 'a' + 'A');
+                firsts.push_back(s);
+                for (int c = 0; c < 20; c += 4) {
+                    lasts.push_back(s + syllables[c] + "son");
+                }
+            }
+        }
+    }
+
+    string next() {
+        string name = firsts[skewed(firsts.size())];
+        name += ' ';
+        name += lasts[skewed(lasts.size())];
+        return name;
+    }
+};
+
+template <typename F>
+double seconds(F&& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void benchmark(size_t records) {
+    unsigned threads = max(1u, thread::hardware_concurrency());
+
+    // Pre-generate the input so only storing is measured
+    vector<string> input(records);
+    {
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                NameGenerator names(t + 1);
+                for (size_t i = records * t / threads; i < records * (t + 1) / threads; ++i) {
+                    input[i] = names.next();
+                }
+            });
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+    }
+
+    // std::string names
+    size_t before = liveHeapBytes.load();
+    vector<PlainPerson> plain(records);
+    double tPlainBuild = seconds([&] {
+        for (size_t i = 0; i < records; ++i) {
+            plain[i].setName(input[i]);
+            plain[i].setAge(int(i % 90) + 1);
+        }
+    });
+    size_t plainBytes = liveHeapBytes.load() - before;
+
+    // Interned names, filled from all threads at once
+    before = liveHeapBytes.load();
+    vector<Person> interned(records);
+    double tInternBuild = seconds([&] {
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i = records * t / threads; i < records * (t + 1) / threads; ++i) {
+                    interned[i].setName(input[i]);
+                    interned[i].setAge(int(i % 90) + 1);
+                }
+            });
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+    });
+    size_t internBytes = liveHeapBytes.load() - before;
+
+    // Reading every name: by value (copy), by view of a std::string, by view into the pool
+    size_t checksum[3] = {0, 0, 0};
+    double tCopy = seconds([&] { for (const auto& p : plain) checksum[0] += p.getName().size(); });
+    double tView = seconds([&] { for (const auto& p : plain) checksum[1] += p.getNameView().size(); });
+    double tInterned = seconds([&] { for (const auto& p : interned) checksum[2] += p.getName().size(); });
+
+    // Counting records with the same name as record 0: string compare against id compare
+    size_t same[2] = {0, 0};
+    double tCompareString = seconds([&] {
+        for (const auto& p : plain) same[0] += p.getNameView() == plain[0].getNameView();
+    });
+    double tCompareId = seconds([&] { for (const auto& p : interned) same[1] += p.sameName(interned[0]); });
+
+    StringPool& pool = StringPool::global();
+    double n = double(records);
+    printf("\n%zu records, %zu distinct names (%.1f MB of text), %u threads\n", records, pool.distinctStrings(),
+           pool.storedBytes() / 1e6, threads);
+    printf("  memory       std::string %8.1f MB (%5.1f B/record)   interned %8.1f MB (%5.1f B/record)\n",
+           plainBytes / 1e6, plainBytes / n, internBytes / 1e6, internBytes / n);
+    printf("  build        std::string %8.1f ns/record              interned %8.1f ns/record\n", tPlainBuild * 1e9 / n,
+           tInternBuild * 1e9 / n);
+    printf("  getName      by value    %8.2f ns   string_view %6.2f ns   interned view %6.2f ns\n", tCopy * 1e9 / n,
+           tView * 1e9 / n, tInterned * 1e9 / n);
+    printf("  equal names  string ==   %8.2f ns                          id ==    %8.2f ns\n",
+           tCompareString * 1e9 / n, tCompareId * 1e9 / n);
+    printf("  results %s\n", checksum[0] == checksum[1] && checksum[1] == checksum[2] && same[0] == same[1]
+                                 ? "match" : "MISMATCH");
+}
+
+int main(int argc, char* argv[]) {
+    Person person;
+    person.setName("John Doe");
+    person.setAge(30);
+    cout << "Name: " << person.getName() << ", Age: " << person.getAge() << endl;
+
+    Dog myDog("Canine", "Buddy");
+    Dog otherDog("Canine", "Max");
+    myDog.bark();
+    cout << "Both dogs share one stored \"" << myDog.getType() << "\": "
+         << (myDog.getType().data() == otherDog.getType().data() ? "yes" : "no") << endl;
+
+    {
+        InternedString temporary("Only used here");
+        cout << "Distinct strings with a temporary: " << StringPool::global().distinctStrings();
+    }
+    cout << ", after it is destroyed: " << StringPool::global().distinctStrings() << endl;
+
+    // Stress: threads repeatedly intern and drop the same few names, so counts keep crossing 0 and back
+    {
+        size_t before = StringPool::global().distinctStrings();
+        vector<thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([t] {
+                const char* names[] = {"hot-name", "warm-name", "Buddy"};
+                for (int i = 0; i < 200000; ++i) {
+                    InternedString s(names[(i + t) % 3]);
+                    InternedString copy = s;
+                    if (copy.view() != names[(i + t) % 3]) {
+                        cerr << "interned text changed" << endl;
+                        abort();
+                    }
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        bool balanced = StringPool::global().distinctStrings() == before;
+        cout << "Concurrent intern/drop stress: " << (balanced ? "ok" : "LEAKED ENTRIES") << endl;
+        if (!balanced) {
+            return 1;
+        }
+    }
+
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000000;
+    benchmark(records);
+
+    return 0;
+}
@@ -50,41 +50,137 @@ Template Declaration: Use the template keyword followed by template parameters i
 Template Definition: Define the class using the template parameters.
 Instantiation: The compiler generates specific versions of the class for the types used.
 Type Deduction: The compiler can deduce the type from the class instantiation.
+Partial Specialization: A class template can have a different implementation for some template arguments, like
+    Pair<T1, T2, PairLayout::Packed> below.
+Triviality: A class template whose special members are all defaulted is trivially copyable exactly when its
+    members are, so Pair<int, double> can be copied with memcpy while Pair<string, string> cannot.
 
 */
 
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 using namespace std;
 
+// How Pair lays out its two members in memory
+enum class PairLayout {
+    Natural,  // ordinary members, aligned, accessed by reference
+    Packed,   // no padding bytes at all; only for trivially copyable types, accessed by value
+};
+
 // Class template for a generic pair
+template <typename T1, typename T2, PairLayout Layout = PairLayout::Natural>
+class Pair;
+
 template <typename T1, typename T2>
-class Pair {
+class Pair<T1, T2, PairLayout::Natural> {
 public:
-    Pair(T1 first, T2 second) : first_(first), second_(second) {}
+    Pair() = default;
 
-    T1 getFirst() const {
-        return first_;
+    // Perfect forwarding: temporaries are moved in, lvalues are copied once, "Hello" builds the string in place
+    template <typename U1, typename U2>
+    Pair(U1&& first, U2&& second) : first_(std::forward<U1>(first)), second_(std::forward<U2>(second)) {}
+
+    // Accessors return references, so reading a Pair<string, string> copies nothing
+    const T1& getFirst() const& { return first_; }
+    T1& getFirst() & { return first_; }
+    T1&& getFirst() && { return std::move(first_); }
+
+    const T2& getSecond() const& { return second_; }
+    T2& getSecond() & { return second_; }
+    T2&& getSecond() && { return std::move(second_); }
+
+    template <typename U>
+    void setFirst(U&& first) {
+        first_ = std::forward<U>(first);
     }
 
-    T2 getSecond() const {
-        return second_;
+    template <typename U>
+    void setSecond(U&& second) {
+        second_ = std::forward<U>(second);
     }
 
-    void setFirst(T1 first) {
-        first_ = first;
+    // Used by structured bindings: auto& [a, b] = pair;
+    template <size_t I>
+    decltype(auto) get() & {
+        if constexpr (I == 0) return (first_); else return (second_);
     }
 
-    void setSecond(T2 second) {
-        second_ = second;
+    template <size_t I>
+    decltype(auto) get() const& {
+        if constexpr (I == 0) return (first_); else return (second_);
+    }
+
+    template <size_t I>
+    decltype(auto) get() && {
+        if constexpr (I == 0) return std::move(first_); else return std::move(second_);
     }
 
 private:
+    // No default member initializers and no user-written copy/move/destructor, so a Pair of trivial
+    // types is itself trivial and can be copied with memcpy
     T1 first_;
     T2 second_;
 };
 
+// Two members can never be reordered to save space: the size is rounded up to the larger alignment either way
+// (Pair<char, double> is 16 bytes in both orders). Removing the padding means giving up alignment, so the
+// packed layout stores raw bytes and copies values in and out with memcpy.
+template <typename T1, typename T2>
+class Pair<T1, T2, PairLayout::Packed> {
+    static_assert(is_trivially_copyable<T1>::value && is_trivially_copyable<T2>::value,
+                  "PairLayout::Packed needs trivially copyable types");
+
+public:
+    Pair() = default;
+
+    Pair(const T1& first, const T2& second) {
+        setFirst(first);
+        setSecond(second);
+    }
+
+    T1 getFirst() const {
+        T1 value;
+        memcpy(&value, bytes_, sizeof(T1));
+        return value;
+    }
+
+    T2 getSecond() const {
+        T2 value;
+        memcpy(&value, bytes_ + sizeof(T1), sizeof(T2));
+        return value;
+    }
+
+    void setFirst(const T1& first) { memcpy(bytes_, &first, sizeof(T1)); }
+    void setSecond(const T2& second) { memcpy(bytes_ + sizeof(T1), &second, sizeof(T2)); }
+
+    template <size_t I>
+    auto get() const {
+        if constexpr (I == 0) return getFirst(); else return getSecond();
+    }
+
+private:
+    unsigned char bytes_[sizeof(T1) + sizeof(T2)];
+};
+
+// Tuple protocol so structured bindings work for every Pair
+template <typename T1, typename T2, PairLayout Layout>
+struct std::tuple_size<Pair<T1, T2, Layout>> : std::integral_constant<size_t, 2> {};
+
+template <size_t I, typename T1, typename T2, PairLayout Layout>
+struct std::tuple_element<I, Pair<T1, T2, Layout>> {
+    using type = conditional_t<I == 0, T1, T2>;
+};
+
+// A Pair of trivial types is trivially copyable, a Pair holding a string is not
+static_assert(is_trivially_copyable<Pair<int, double>>::value, "Pair<int, double> can be memcpy'd");
+static_assert(!is_trivially_copyable<Pair<string, string>>::value, "Pair<string, string> cannot");
+static_assert(sizeof(Pair<char, double, PairLayout::Packed>) == 9, "packed layout has no padding");
+
 int main() {
     // Using the template class with different types
     Pair<int, double> intDoublePair(1, 2.5);
@@ -97,5 +193,17 @@ int main() {
     intDoublePair.setSecond(20.5);
     cout << "Updated intDoublePair: (" << intDoublePair.getFirst() << ", " << intDoublePair.getSecond() << ")" << endl;
 
+    // Structured bindings
+    auto& [greeting, target] = stringPair;
+    target = "Templates";
+    cout << "After binding: " << greeting << ", " << stringPair.getSecond() << endl;
+
+    // Layouts
+    Pair<char, double> natural('a', 1.5);
+    Pair<char, double, PairLayout::Packed> packed('a', 1.5);
+    auto [c, d] = packed;
+    cout << "sizeof natural Pair<char, double>: " << sizeof(natural) << ", packed: " << sizeof(packed)
+         << " -> (" << c << ", " << d << ")" << endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,418 @@
+/*
+
+---------- FLAT (OPEN-ADDRESSING) HASH MAP ----------
+
+std::unordered_map stores every entry in its own heap node and keeps a linked list per bucket. Each insert is an
+allocation, and each lookup follows at least two pointers (bucket -> node -> next node ...), which are usually cache
+misses on large maps.
+
+An open-addressing map stores the entries themselves in one flat array. FlatHashMap follows the design of Google's
+Swiss table, with the entries stored as Pair<K, V> from class_template.cpp:
+
+1. Slots: One contiguous array of Pair<K, V>. No node allocations, no pointers between entries.
+2. Control Bytes: A parallel array with one byte per slot: EMPTY, or the low 7 bits of the key's hash ("h2").
+3. Group Probing: A lookup loads 16 control bytes at once into an SSE2 register and compares all of them against h2
+   in one instruction. Only slots whose control byte matches (on average far less than one false match) are
+   compared with the real key. A group that contains an EMPTY byte ends the search.
+
+---------- HOW IT WORKS ----------
+
+Linear Probing: An entry lives at the first free slot at or after its home slot (hash & mask). The control array
+                has 16 extra bytes mirroring the first 16 so a group can be loaded across the wrap-around point.
+Tombstone-Free Erase: Instead of leaving a "deleted" marker, erase() shifts the following entries of the same run
+                      back into the hole (backward-shift deletion). The table never fills up with tombstones, so
+                      lookups stay fast after many erases and no cleanup rehash is needed.
+Heterogeneous Lookup: With a transparent hash and equality (is_transparent), find() accepts any type comparable to
+                      the key, e.g. a string_view or a const char* for a map with string keys, with no temporary string.
+Reserve / Rehash: reserve(n) sizes the table so n entries fit under the 7/8 maximum load factor; rehash(n) sets the
+                  slot count directly.
+
+---------- RULES AND GUIDELINES ----------
+
+References Are Not Stable: Inserting may rehash and erasing may shift entries, so pointers/references into the map
+                           are invalidated by insert and erase (unlike std::unordered_map).
+Hash Quality: Hashes are passed through a mixing step, so even std::hash<int> (the identity) spreads well.
+Compile: g++ -std=c++17 -O2 flat_hash_map.cpp
+Run: ./a.out [max entries, default 1000000]   (e.g. 100000000 on a machine with enough memory)
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Pair from class_template.cpp (natural layout)
+template <typename T1, typename T2>
+class Pair {
+public:
+    Pair() = default;
+
+    template <typename U1, typename U2>
+    Pair(U1&& first, U2&& second) : first_(std::forward<U1>(first)), second_(std::forward<U2>(second)) {}
+
+    const T1& getFirst() const& { return first_; }
+    T1& getFirst() & { return first_; }
+
+    const T2& getSecond() const& { return second_; }
+    T2& getSecond() & { return second_; }
+
+    template <typename U>
+    void setSecond(U&& second) {
+        second_ = std::forward<U>(second);
+    }
+
+private:
+    T1 first_;
+    T2 second_;
+};
+
+// Transparent hash/equality for string keys: lookups with string_view or const char* need no temporary string
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(string_view s) const { return hash<string_view>()(s); }
+};
+
+struct StringEqual {
+    using is_transparent = void;
+    bool operator()(string_view a, string_view b) const { return a == b; }
+};
+
+template <typename K, typename V, typename Hash = hash<K>, typename Eq = equal_to<K>>
+class FlatHashMap {
+public:
+    using value_type = Pair<K, V>;
+
+private:
+    static constexpr size_t GROUP_WIDTH = 16;
+    static constexpr int8_t EMPTY = -128;  // 0b10000000; full slots hold h2 in 0..127
+
+    int8_t* ctrl = nullptr;        // capacity + GROUP_WIDTH bytes; the tail mirrors the first GROUP_WIDTH
+    value_type* slots = nullptr;   // raw storage, constructed only where ctrl is full
+    size_t capacity = 0;           // power of two, or 0 before the first insert
+    size_t count = 0;
+    Hash hasher;
+    Eq equal;
+
+    // Bit i set when control byte i of the group equals `value`
+    static uint32_t matchByte(const int8_t* group, int8_t value) {
+#if defined(__SSE2__)
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+            mask |= static_cast<uint32_t>(group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    // Mixes the user hash so both the home slot (high bits) and h2 (low 7 bits) are well distributed
+    template <typename Q>
+    size_t mixedHash(const Q& key) const {
+        uint64_t h = static_cast<uint64_t>(hasher(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    size_t home(size_t hash) const { return (hash >> 7) & (capacity - 1); }
+
+    void setCtrl(size_t i, int8_t value) {
+        ctrl[i] = value;
+        if (i < GROUP_WIDTH) {
+            ctrl[capacity + i] = value;  // keep the mirror in sync for wrap-around group loads
+        }
+    }
+
+    template <typename Q>
+    size_t findIndex(const Q& key) const {
+        if (count == 0) {
+            return capacity;
+        }
+        size_t hash = mixedHash(key);
+        int8_t tag = h2(hash);
+        size_t mask = capacity - 1;
+        for (size_t pos = home(hash);; pos = (pos + GROUP_WIDTH) & mask) {
+            const int8_t* group = ctrl + pos;
+            for (uint32_t m = matchByte(group, tag); m != 0; m &= m - 1) {
+                size_t i = (pos + static_cast<size_t>(__builtin_ctz(m))) & mask;
+                if (equal(slots[i].getFirst(), key)) {
+                    return i;
+                }
+            }
+            if (matchByte(group, EMPTY) != 0) {
+                return capacity;  // not found
+            }
+        }
+    }
+
+    // First empty slot at or after the home slot of `hash`
+    size_t findEmpty(size_t hash) const {
+        size_t mask = capacity - 1;
+        for (size_t pos = home(hash);; pos = (pos + GROUP_WIDTH) & mask) {
+            uint32_t m = matchByte(ctrl + pos, EMPTY);
+            if (m != 0) {
+                return (pos + static_cast<size_t>(__builtin_ctz(m))) & mask;
+            }
+        }
+    }
+
+    void allocate(size_t newCapacity) {
+        capacity = newCapacity;
+        ctrl = static_cast<int8_t*>(::operator new(capacity + GROUP_WIDTH));
+        memset(ctrl, EMPTY, capacity + GROUP_WIDTH);
+        slots = static_cast<value_type*>(::operator new(capacity * sizeof(value_type), align_val_t(alignof(value_type))));
+    }
+
+    void release() {
+        if (!ctrl) {
+            return;
+        }
+        if constexpr (!is_trivially_destructible<value_type>::value) {
+            for (size_t i = 0; i < capacity; ++i) {
+                if (ctrl[i] >= 0) {
+                    slots[i].~value_type();
+                }
+            }
+        }
+        ::operator delete(ctrl);
+        ::operator delete(slots, align_val_t(alignof(value_type)));
+        ctrl = nullptr;
+        slots = nullptr;
+    }
+
+    void resize(size_t newCapacity) {
+        int8_t* oldCtrl = ctrl;
+        value_type* oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldCtrl[i] >= 0) {
+                size_t hash = mixedHash(oldSlots[i].getFirst());
+                size_t j = findEmpty(hash);
+                new (&slots[j]) value_type(std::move(oldSlots[i]));
+                setCtrl(j, h2(hash));
+                oldSlots[i].~value_type();
+            }
+        }
+        if (oldCtrl) {
+            ::operator delete(oldCtrl);
+            ::operator delete(oldSlots, align_val_t(alignof(value_type)));
+        }
+    }
+
+    static size_t capacityFor(size_t entries) {
+        size_t cap = GROUP_WIDTH;
+        while (cap * 7 / 8 < entries) {
+            cap *= 2;
+        }
+        return cap;
+    }
+
+public:
+    FlatHashMap() = default;
+
+    ~FlatHashMap() { release(); }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t bucketCount() const { return capacity; }
+    double loadFactor() const { return capacity ? double(count) / capacity : 0.0; }
+
+    // Makes room for n entries without further rehashing
+    void reserve(size_t n) {
+        if (capacityFor(n) > capacity) {
+            resize(capacityFor(n));
+        }
+    }
+
+    // Sets the slot count (rounded up to a power of two, never below what the current size needs)
+    void rehash(size_t slotCount) {
+        size_t cap = capacityFor(count);
+        while (cap < slotCount) {
+            cap *= 2;
+        }
+        if (cap != capacity) {
+            resize(cap);
+        }
+    }
+
+    // Inserts if the key is absent; returns the entry and whether it was inserted
+    template <typename KeyArg, typename... ValueArgs>
+    pair<value_type*, bool> tryEmplace(KeyArg&& key, ValueArgs&&... valueArgs) {
+        size_t found = findIndex(key);
+        if (found != capacity) {
+            return {&slots[found], false};
+        }
+        if ((count + 1) > capacity * 7 / 8) {
+            resize(capacity ? capacity * 2 : GROUP_WIDTH);
+        }
+        size_t hash = mixedHash(key);
+        size_t i = findEmpty(hash);
+        new (&slots[i]) value_type(K(std::forward<KeyArg>(key)), V(std::forward<ValueArgs>(valueArgs)...));
+        setCtrl(i, h2(hash));
+        ++count;
+        return {&slots[i], true};
+    }
+
+    bool insert(const K& key, const V& value) { return tryEmplace(key, value).second; }
+
+    V& operator[](const K& key) { return tryEmplace(key).first->getSecond(); }
+
+    // Heterogeneous lookup is enabled when both Hash and Eq are transparent
+    template <typename Q, typename H = Hash, typename E = Eq,
+              typename = void_t<typename H::is_transparent, typename E::is_transparent>>
+    V* find(const Q& key) {
+        size_t i = findIndex(key);
+        return i == capacity ? nullptr : &slots[i].getSecond();
+    }
+
+    V* find(const K& key) {
+        size_t i = findIndex(key);
+        return i == capacity ? nullptr : &slots[i].getSecond();
+    }
+
+    bool contains(const K& key) const { return findIndex(key) != capacity; }
+
+    // Backward-shift deletion: no tombstones are left behind
+    bool erase(const K& key) {
+        size_t hole = findIndex(key);
+        if (hole == capacity) {
+            return false;
+        }
+        slots[hole].~value_type();
+        --count;
+
+        size_t mask = capacity - 1;
+        for (size_t j = (hole + 1) & mask; ctrl[j] != EMPTY; j = (j + 1) & mask) {
+            size_t k = home(mixedHash(slots[j].getFirst()));
+            // The entry at j may move into the hole only if its home is not in (hole, j] (cyclically)
+            bool homeBetween = hole <= j ? (hole < k && k <= j) : (hole < k || k <= j);
+            if (!homeBetween) {
+                new (&slots[hole]) value_type(std::move(slots[j]));
+                slots[j].~value_type();
+                setCtrl(hole, ctrl[j]);
+                hole = j;
+            }
+        }
+        setCtrl(hole, EMPTY);
+        return true;
+    }
+
+    template <typename F>
+    void forEach(F&& f) {
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0) {
+                f(slots[i]);
+            }
+        }
+    }
+};
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double nsPerOp(size_t ops, F&& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / double(ops);
+}
+
+void benchmark(size_t n) {
+    mt19937_64 rng(n);
+    vector<uint64_t> keys(n), missing(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = rng();
+        missing[i] = rng();
+    }
+    vector<uint64_t> shuffled = keys;
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    uint64_t sinkFlat = 0, sinkStd = 0;
+
+    FlatHashMap<uint64_t, uint64_t> flat;
+    unordered_map<uint64_t, uint64_t> stdMap;
+
+    double insFlat = nsPerOp(n, [&] { for (size_t i = 0; i < n; ++i) flat.insert(keys[i], i); });
+    double insStd = nsPerOp(n, [&] { for (size_t i = 0; i < n; ++i) stdMap.emplace(keys[i], i); });
+
+    double hitFlat = nsPerOp(n, [&] { for (uint64_t k : shuffled) sinkFlat += *flat.find(k); });
+    double hitStd = nsPerOp(n, [&] { for (uint64_t k : shuffled) sinkStd += stdMap.find(k)->second; });
+
+    double missFlat = nsPerOp(n, [&] { for (uint64_t k : missing) sinkFlat += flat.find(k) != nullptr; });
+    double missStd = nsPerOp(n, [&] { for (uint64_t k : missing) sinkStd += stdMap.count(k); });
+
+    double eraseFlat = nsPerOp(n, [&] { for (uint64_t k : shuffled) flat.erase(k); });
+    double eraseStd = nsPerOp(n, [&] { for (uint64_t k : shuffled) stdMap.erase(k); });
+
+    printf("%10zu   insert %6.1f / %6.1f   hit %6.1f / %6.1f   miss %6.1f / %6.1f   erase %6.1f / %6.1f %s\n", n,
+           insFlat, insStd, hitFlat, hitStd, missFlat, missStd, eraseFlat, eraseStd,
+           sinkFlat == sinkStd && flat.empty() && stdMap.empty() ? "" : "  MISMATCH");
+}
+
+int main(int argc, char* argv[]) {
+    // Heterogeneous lookup with string keys
+    FlatHashMap<string, int, StringHash, StringEqual> ages;
+    ages.insert("Suraj", 20);
+    ages["John Doe"] = 30;
+    string_view who = "John Doe";
+    cout << who << " is " << *ages.find(who) << ", Suraj is " << *ages.find("Suraj") << endl;
+    ages.erase("Suraj");
+    cout << "After erase: " << ages.size() << " entry, Suraj " << (ages.contains("Suraj") ? "found" : "gone") << endl;
+
+    // Randomized check against std::unordered_map, with many erases to exercise backward shifting
+    FlatHashMap<int, int> check;
+    unordered_map<int, int> reference;
+    mt19937 rng(5);
+    for (int step = 0; step < 200000; ++step) {
+        int key = static_cast<int>(rng() % 5000);
+        if (rng() % 3 == 0) {
+            bool a = check.erase(key), b = reference.erase(key) == 1;
+            if (a != b) { cout << "erase mismatch" << endl; return 1; }
+        } else {
+            check.insert(key, step);
+            reference.emplace(key, step);
+        }
+    }
+    bool ok = check.size() == reference.size();
+    for (const auto& [k, v] : reference) {
+        const int* found = check.find(k);
+        ok = ok && found && *found == v;
+    }
+    cout << "Randomized check against unordered_map: " << (ok ? "ok" : "FAILED") << endl;
+
+    size_t maxEntries = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    printf("\n   entries   (ns/op, FlatHashMap / std::unordered_map)\n");
+    for (size_t n = 1000; n <= maxEntries; n *= 10) {
+        benchmark(n);
+    }
+
+    return ok ? 0 : 1;
+}
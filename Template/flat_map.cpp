@@ -0,0 +1,388 @@
+/*
+
+---------- SORTED FLAT MAP ----------
+
+std::map is a red-black tree: every entry is a separate heap node, and a lookup or a range scan jumps from node to
+node through pointers. FlatMap keeps the same ordered-map interface on top of one sorted array of Pair<K, V> (from
+class_template.cpp):
+
+1. Range Scans: The entries of a key range are next to each other in memory, so a scan is a linear walk that the
+   hardware prefetcher streams in.
+2. Bulk Insert: A batch is sorted on its own and then merged with the existing array in one linear pass, instead of
+   being inserted one element at a time.
+3. Point Lookup: A copy of the keys is kept in Eytzinger (BFS / heap) order, where the children of position k are 2k
+   and 2k + 1. A binary search then walks down that array with no unpredictable branch, and the next levels of the
+   search sit on a few cache lines that can be prefetched ahead of time.
+
+---------- HOW IT WORKS ----------
+
+radixSort: For integral keys, a parallel LSD radix sort on 8-bit digits. Each thread counts the digits of its own
+           chunk, one prefix sum over (digit, thread) gives every thread its own output positions, and then all threads
+           scatter at once. Passes where every key has the same digit are skipped. Other key types use std::stable_sort.
+insertBulk: Sorts the batch, merges it with the current entries (a key in the batch replaces an existing one; inside a
+            batch the last occurrence wins) and rebuilds the Eytzinger index.
+lowerBound: Branchless descent: k = 2k + (keys[k] < key). The answer is found by removing the trailing 1 bits of k
+            (the right turns taken after the last left turn).
+
+---------- USES ----------
+
+Read-Mostly Tables: Configuration, symbol tables, price lists built once and queried many times.
+Time Series And Logs: Records sorted by timestamp and scanned by range.
+Batch Pipelines: Data arriving in large batches that can be merged in at once.
+
+---------- RULES AND GUIDELINES ----------
+
+Prefer Batches: insert() of a single entry shifts the array and rebuilds the index (O(n)); collect entries and call
+                insertBulk() instead.
+Stable Iteration: Entries are always visited in key order; pointers into the map are invalidated by any insert.
+Compile: g++ -std=c++17 -O2 -pthread flat_map.cpp
+Run: ./a.out [entries, default 1000000]
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Pair from class_template.cpp (natural layout)
+template <typename T1, typename T2>
+class Pair {
+public:
+    Pair() = default;
+
+    template <typename U1, typename U2>
+    Pair(U1&& first, U2&& second) : first_(std::forward<U1>(first)), second_(std::forward<U2>(second)) {}
+
+    const T1& getFirst() const& { return first_; }
+    T1& getFirst() & { return first_; }
+
+    const T2& getSecond() const& { return second_; }
+    T2& getSecond() & { return second_; }
+
+private:
+    T1 first_;
+    T2 second_;
+};
+
+// ---------- PARALLEL LSD RADIX SORT ----------
+
+// Maps a key to an unsigned integer with the same order (the sign bit is flipped for signed types)
+template <typename K>
+auto radixKey(K key) {
+    using U = make_unsigned_t<K>;
+    U u = static_cast<U>(key);
+    if constexpr (is_signed<K>::value) {
+        u ^= U(1) << (sizeof(U) * 8 - 1);
+    }
+    return u;
+}
+
+// Stable sort of Pair<K, V> by an integral key, 8 bits per pass
+template <typename K, typename V>
+void radixSort(vector<Pair<K, V>>& data, unsigned threadCount = thread::hardware_concurrency()) {
+    static_assert(is_integral<K>::value, "radixSort needs an integral key");
+    constexpr size_t RADIX = 256;
+    const size_t n = data.size();
+    if (n < 2) {
+        return;
+    }
+    threadCount = max(1u, min<unsigned>(threadCount, static_cast<unsigned>(n / 65536 + 1)));
+
+    vector<Pair<K, V>> buffer(n);
+    vector<Pair<K, V>>* from = &data;
+    vector<Pair<K, V>>* to = &buffer;
+    vector<size_t> counts(threadCount * RADIX);
+
+    auto chunkBegin = [&](unsigned t) { return n * t / threadCount; };
+
+    // Runs f(t) on threadCount threads (the calling thread takes t = 0)
+    auto parallel = [&](auto&& f) {
+        vector<thread> workers;
+        for (unsigned t = 1; t < threadCount; ++t) {
+            workers.emplace_back(f, t);
+        }
+        f(0u);
+        for (thread& w : workers) {
+            w.join();
+        }
+    };
+
+    for (unsigned shift = 0; shift < sizeof(K) * 8; shift += 8) {
+        auto digit = [shift](const Pair<K, V>& p) { return (radixKey(p.getFirst()) >> shift) & (RADIX - 1); };
+
+        fill(counts.begin(), counts.end(), 0);
+        parallel([&](unsigned t) {
+            size_t* c = &counts[t * RADIX];
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+                ++c[digit((*from)[i])];
+            }
+        });
+
+        // Skip the pass if every key has the same digit
+        size_t firstDigit = digit((*from)[0]);
+        size_t sameDigit = 0;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            sameDigit += counts[t * RADIX + firstDigit];
+        }
+        if (sameDigit == n) {
+            continue;
+        }
+
+        // Exclusive prefix sum in (digit, thread) order: output position of each thread's first key per digit
+        size_t offset = 0;
+        for (size_t d = 0; d < RADIX; ++d) {
+            for (unsigned t = 0; t < threadCount; ++t) {
+                size_t c = counts[t * RADIX + d];
+                counts[t * RADIX + d] = offset;
+                offset += c;
+            }
+        }
+
+        parallel([&](unsigned t) {
+            size_t* pos = &counts[t * RADIX];
+            for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+                (*to)[pos[digit((*from)[i])]++] = std::move((*from)[i]);
+            }
+        });
+        swap(from, to);
+    }
+
+    if (from != &data) {
+        data.swap(buffer);
+    }
+}
+
+// ---------- FLAT MAP ----------
+
+template <typename K, typename V>
+class FlatMap {
+public:
+    using value_type = Pair<K, V>;
+    using const_iterator = typename vector<value_type>::const_iterator;
+
+private:
+    vector<value_type> entries;  // sorted by key, no duplicates
+    vector<K> eytzinger;         // keys in BFS order, 1-based (index 0 unused)
+    vector<uint32_t> rank;       // rank[k] = position in entries of eytzinger[k]
+
+    static void sortBatch(vector<value_type>& batch) {
+        if constexpr (is_integral<K>::value) {
+            radixSort(batch);
+        } else {
+            stable_sort(batch.begin(), batch.end(),
+                        [](const value_type& a, const value_type& b) { return a.getFirst() < b.getFirst(); });
+        }
+    }
+
+    // In-order walk of the implicit tree assigns sorted entries to BFS positions
+    size_t buildIndex(size_t i, size_t k) {
+        if (k < eytzinger.size()) {
+            i = buildIndex(i, 2 * k);
+            eytzinger[k] = entries[i].getFirst();
+            rank[k] = static_cast<uint32_t>(i++);
+            i = buildIndex(i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    void rebuildIndex() {
+        eytzinger.assign(entries.size() + 1, K());
+        rank.assign(entries.size() + 1, 0);
+        buildIndex(0, 1);
+    }
+
+public:
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    // Merges a batch of entries into the map; batch keys replace existing ones, later batch entries win
+    void insertBulk(vector<value_type> batch) {
+        sortBatch(batch);
+
+        // Keep only the last entry of each run of equal keys
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (i + 1 < batch.size() && !(batch[i].getFirst() < batch[i + 1].getFirst())) {
+                continue;
+            }
+            if (kept != i) {
+                batch[kept] = std::move(batch[i]);
+            }
+            ++kept;
+        }
+        batch.resize(kept);
+
+        vector<value_type> merged;
+        merged.reserve(entries.size() + batch.size());
+        size_t a = 0, b = 0;
+        while (a < entries.size() && b < batch.size()) {
+            const K& ka = entries[a].getFirst();
+            const K& kb = batch[b].getFirst();
+            if (ka < kb) {
+                merged.push_back(std::move(entries[a++]));
+            } else {
+                if (!(kb < ka)) {
+                    ++a;  // same key: the batch entry replaces the old one
+                }
+                merged.push_back(std::move(batch[b++]));
+            }
+        }
+        move(entries.begin() + a, entries.end(), back_inserter(merged));
+        move(batch.begin() + b, batch.end(), back_inserter(merged));
+
+        entries.swap(merged);
+        rebuildIndex();
+    }
+
+    void insert(const K& key, const V& value) {
+        vector<value_type> batch;
+        batch.emplace_back(key, value);
+        insertBulk(std::move(batch));
+    }
+
+    // Position of the first entry with a key not less than `key` (size() if none)
+    size_t lowerBound(const K& key) const {
+        const size_t n = entries.size();
+        const K* keys = eytzinger.data();
+        size_t k = 1;
+        while (k <= n) {
+            __builtin_prefetch(keys + 16 * k);  // the node four levels down
+            k = 2 * k + (keys[k] < key);
+        }
+        k >>= __builtin_ffsll(static_cast<long long>(~k));  // undo the right turns after the last left turn
+        return k == 0 ? n : rank[k];
+    }
+
+    const V* find(const K& key) const {
+        size_t i = lowerBound(key);
+        if (i < entries.size() && !(key < entries[i].getFirst())) {
+            return &entries[i].getSecond();
+        }
+        return nullptr;
+    }
+
+    // Calls f(entry) for every key in [lo, hi)
+    template <typename F>
+    void forEachInRange(const K& lo, const K& hi, F&& f) const {
+        for (size_t i = lowerBound(lo); i < entries.size() && entries[i].getFirst() < hi; ++i) {
+            f(entries[i]);
+        }
+    }
+};
+
+// ---------- BENCHMARK ----------
+
+template <typename F>
+double nsPer(size_t ops, F&& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / double(ops);
+}
+
+int main(int argc, char* argv[]) {
+    FlatMap<int, double> prices;
+    prices.insertBulk({{30, 3.5}, {10, 1.25}, {20, 2.0}, {10, 1.5}});
+    prices.insert(-5, 0.5);
+    cout << "Entries:";
+    for (const auto& p : prices) {
+        cout << " (" << p.getFirst() << ", " << p.getSecond() << ")";
+    }
+    cout << "\nfind(10) = " << *prices.find(10) << ", find(15) " << (prices.find(15) ? "found" : "missing") << endl;
+    cout << "Range [0, 25):";
+    prices.forEachInRange(0, 25, [](const Pair<int, double>& p) { cout << " " << p.getFirst(); });
+    cout << endl;
+
+    const size_t n = max<size_t>(1, argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000);
+    mt19937_64 rng(7);
+    vector<Pair<int64_t, double>> records(n);
+    for (size_t i = 0; i < n; ++i) {
+        records[i] = Pair<int64_t, double>(static_cast<int64_t>(rng() >> 1) - (int64_t(1) << 61), double(i));
+    }
+
+    // Sorting alone: radix against std::sort
+    auto byKey = [](const Pair<int64_t, double>& a, const Pair<int64_t, double>& b) {
+        return a.getFirst() < b.getFirst();
+    };
+    vector<Pair<int64_t, double>> a = records, b = records;
+    double tStdSort = nsPer(n, [&] { stable_sort(a.begin(), a.end(), byKey); });
+    double tRadix = nsPer(n, [&] { radixSort(b); });
+    bool sortOk = equal(a.begin(), a.end(), b.begin(), [](const auto& x, const auto& y) {
+        return x.getFirst() == y.getFirst() && x.getSecond() == y.getSecond();
+    });
+
+    // Build
+    FlatMap<int64_t, double> flat;
+    map<int64_t, double> tree;
+    double tBuildFlat = nsPer(n, [&] { flat.insertBulk(records); });
+    double tBuildTree = nsPer(n, [&] { for (const auto& r : records) tree[r.getFirst()] = r.getSecond(); });
+
+    // Point lookups in random order, half hits and half misses
+    vector<int64_t> probes(n);
+    for (size_t i = 0; i < n; ++i) {
+        probes[i] = (i & 1) ? records[rng() % n].getFirst() : static_cast<int64_t>(rng());
+    }
+    double sumFlat = 0, sumTree = 0;
+    double tFindFlat = nsPer(n, [&] {
+        for (int64_t key : probes) {
+            const double* v = flat.find(key);
+            sumFlat += v ? *v : 0.0;
+        }
+    });
+    double tFindTree = nsPer(n, [&] {
+        for (int64_t key : probes) {
+            auto it = tree.find(key);
+            sumTree += it != tree.end() ? it->second : 0.0;
+        }
+    });
+
+    // Range scans of about 1000 entries each: the key range divided by n, times 1000 (everything for small n)
+    const size_t scans = 1000;
+    const uint64_t span = uint64_t(a.back().getFirst()) - uint64_t(a.front().getFirst());
+    const bool wholeRange = n <= 1000 || span / n >= uint64_t(INT64_MAX) / 1000;
+    const int64_t width = wholeRange ? INT64_MAX : static_cast<int64_t>(span / n * 1000 + 1);
+    auto upperFor = [&](int64_t lo) { return lo > INT64_MAX - width ? INT64_MAX : lo + width; };  // saturating
+    size_t visitedFlat = 0, visitedTree = 0;
+    auto scanFlat = [&](int64_t lo) {
+        flat.forEachInRange(lo, upperFor(lo), [&](const Pair<int64_t, double>& p) {
+            sumFlat += p.getSecond();
+            ++visitedFlat;
+        });
+    };
+    auto scanTree = [&](int64_t lo) {
+        const int64_t hi = upperFor(lo);
+        for (auto it = tree.lower_bound(lo); it != tree.end() && it->first < hi; ++it) {
+            sumTree += it->second;
+            ++visitedTree;
+        }
+    };
+    vector<int64_t> starts(scans);
+    for (int64_t& lo : starts) {
+        lo = a[rng() % n].getFirst();
+    }
+    double tScanFlat = nsPer(scans, [&] { for (int64_t lo : starts) scanFlat(lo); });
+    double tScanTree = nsPer(scans, [&] { for (int64_t lo : starts) scanTree(lo); });
+
+    bool ok = sortOk && flat.size() == tree.size() && visitedFlat == visitedTree && sumFlat == sumTree;
+    printf("\n%zu records (Pair<int64_t, double>), %u threads\n", n, thread::hardware_concurrency());
+    printf("  sort         std::stable_sort %7.1f ns/elem   radixSort      %7.1f ns/elem\n", tStdSort, tRadix);
+    printf("  build        std::map         %7.1f ns/elem   FlatMap bulk   %7.1f ns/elem\n", tBuildTree, tBuildFlat);
+    printf("  point find   std::map         %7.1f ns/op     FlatMap        %7.1f ns/op\n", tFindTree, tFindFlat);
+    printf("  range scan   std::map         %7.1f us/scan   FlatMap        %7.1f us/scan   (~%zu entries per scan)\n",
+           tScanTree / 1000, tScanFlat / 1000, visitedFlat / scans);
+    printf("  results %s\n", ok ? "match" : "MISMATCH");
+
+    return ok ? 0 : 1;
+}
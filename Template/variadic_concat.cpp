@@ -0,0 +1,185 @@
+/*
+
+---------- VARIADIC TEMPLATES ----------
+
+A variadic template takes any number of template arguments, written as a parameter pack (typename... Args).
+Inside the template the pack is expanded with `...`, and since C++17 a fold expression such as (f(args) + ...)
+applies an operation to every element of the pack without writing any recursion.
+
+---------- VARIADIC CONCAT ----------
+
+string add(const string&, const string&) in Polymorphism/function_overloading.cpp and add<std::string> in
+function_template.cpp join two strings. Chaining them, add(add(add(a, b), c), d), creates a new string at every step:
+n pieces cost n - 1 allocations, and the first piece is copied n - 1 times, so the work grows with n^2.
+
+concat(args...) sees all pieces at once, so it can:
+
+1. Convert every argument to a view of its characters (numbers are formatted with to_chars into a small buffer).
+2. Add up the lengths with a fold expression.
+3. Allocate the result exactly once and copy every piece into place.
+
+---------- USES ----------
+
+Building Messages: Log lines, error messages and keys made of several parts.
+Generated Text: SQL, JSON or CSV fragments built from strings and numbers.
+Any Function With "Any Number Of" Arguments: printf-like APIs, make_unique, emplace_back.
+
+---------- RULES AND GUIDELINES ----------
+
+Accepted Arguments: std::string, std::string_view, const char*, char and any arithmetic type (bool prints 0/1).
+One Allocation: Only the result is allocated; numbers are formatted on the stack.
+Pack Expansion: Every `...` must expand a pack; a fold expression needs parentheses around it.
+Compile: g++ -std=c++17 -O2 variadic_concat.cpp
+
+*/
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Function template for adding two values (from function_template.cpp)
+template <typename T>
+T add(T a, T b) {
+    return a + b;
+}
+
+// One concat argument as a sequence of characters
+class Piece {
+private:
+    char buffer[32];  // numbers are formatted here; enough for any 64-bit integer or shortest double
+    string_view view;
+
+public:
+    Piece(const string& s) : view(s) {}
+    Piece(string_view s) : view(s) {}
+    Piece(const char* s) : view(s) {}
+    Piece(char c) : view(buffer, 1) { buffer[0] = c; }
+
+    template <typename T, typename = enable_if_t<is_arithmetic<T>::value && !is_same<T, char>::value>>
+    Piece(T number) {
+        to_chars_result result;
+        if constexpr (is_same<T, bool>::value) {
+            result = to_chars(buffer, buffer + sizeof(buffer), int(number));  // to_chars(bool) is deleted
+        } else {
+            result = to_chars(buffer, buffer + sizeof(buffer), number);
+        }
+        view = string_view(buffer, static_cast<size_t>(result.ptr - buffer));
+    }
+
+    // A Piece points into its own buffer, so it must never be copied or moved
+    Piece(const Piece&) = delete;
+    Piece& operator=(const Piece&) = delete;
+
+    size_t size() const { return view.size(); }
+    const char* data() const { return view.data(); }
+};
+
+template <typename... Pieces>
+string concatPieces(const Pieces&... pieces) {
+    size_t total = (size_t(0) + ... + pieces.size());
+    string result(total, '\0');  // the only allocation
+    char* out = result.data();
+    ((memcpy(out, pieces.data(), pieces.size()), out += pieces.size()), ...);
+    return result;
+}
+
+// Joins strings, string_views, C strings, chars and numbers with a single allocation
+template <typename... Args>
+string concat(const Args&... args) {
+    return concatPieces(Piece(args)...);
+}
+
+// ---------- BENCHMARK ----------
+
+// Counts every heap allocation made by the program
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Pieces are long enough to defeat the small-string optimization, like real log lines
+static vector<string> makePieces(size_t n) {
+    vector<string> pieces;
+    for (size_t i = 0; i < n; ++i) {
+        pieces.push_back("field-" + to_string(i) + "-value-with-some-padding;");
+    }
+    return pieces;
+}
+
+template <size_t... I>
+string chainAdd(const vector<string>& p, index_sequence<I...>) {
+    string result;
+    ((result = add(result, p[I])), ...);
+    return result;
+}
+
+template <size_t... I>
+string chainConcat(const vector<string>& p, index_sequence<I...>) {
+    return concat(p[I]...);
+}
+
+template <size_t N>
+void benchmark() {
+    vector<string> pieces = makePieces(N);
+    const int repeats = 20000;
+    string a, b;
+
+    size_t before = allocationCount;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        a = chainAdd(pieces, make_index_sequence<N>());
+    }
+    double tAdd = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / repeats;
+    double allocAdd = double(allocationCount - before) / repeats;
+
+    before = allocationCount;
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        b = chainConcat(pieces, make_index_sequence<N>());
+    }
+    double tConcat = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / repeats;
+    double allocConcat = double(allocationCount - before) / repeats;
+
+    printf("%6zu %12.0f %10.1f %12.0f %10.1f   %s\n", N, tAdd, allocAdd, tConcat, allocConcat,
+           a == b ? "" : "MISMATCH");
+}
+
+int main() {
+    string name = "Suraj";
+    string_view greeting = "Hello, ";
+    cout << concat(greeting, name, '!', " You are ", 20, " and scored ", 91.5, " points. Passed: ", true) << endl;
+
+    printf("\npieces   add ns/call  add allocs  concat ns/call  concat allocs\n");
+    benchmark<2>();
+    benchmark<4>();
+    benchmark<8>();
+    benchmark<16>();
+    benchmark<32>();
+    benchmark<64>();
+
+    return 0;
+}